@@ -0,0 +1,50 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_INCLUDES_IOTRACE_EVENT_COMPLETION_H
+#define SOURCE_INCLUDES_IOTRACE_EVENT_COMPLETION_H
+
+#ifdef __KERNEL__
+#include "iotrace_event.h"
+#else
+#include <octf/trace/iotrace_event.h>
+#endif
+
+/**
+ * Event type value of IO completion events
+ *
+ * @note Allocated from the upper range of the iotrace_event_type numbering
+ *       space so it cannot collide with types defined by the shared event
+ *       header; the definition moves into iotrace_event.h together with
+ *       the next event format version bump.
+ */
+#define IOTRACE_EVENT_TYPE_IO_COMPLETION 100
+
+/**
+ * @brief IO completion trace event
+ *
+ * Emitted into the same per CPU ring as the submission events when a
+ * traced bio completes. A completion pairs with its submission through
+ * device id, LBA and length; request latency is the difference of the
+ * two events' timestamps.
+ */
+struct iotrace_event_completion {
+    /** Trace event header */
+    struct iotrace_event_hdr hdr;
+
+    /** Address of completed IO in sectors */
+    uint64_t lba;
+
+    /** Size of completed IO in sectors */
+    uint32_t len;
+
+    /** Completion result (0 on success, negative error code otherwise) */
+    int32_t error;
+
+    /** Device id */
+    uint32_t dev_id;
+} __attribute__((packed, aligned(8)));
+
+#endif  // SOURCE_INCLUDES_IOTRACE_EVENT_COMPLETION_H
@@ -23,6 +23,22 @@
 
 #define IOTRACE_PROCFS_SIZE_FILE_NAME "size"
 
+#define IOTRACE_PROCFS_WATERMARK_FILE_NAME "notify_watermark"
+
+#define IOTRACE_PROCFS_FILTER_OPS_FILE_NAME "filter_ops"
+
+#define IOTRACE_PROCFS_FILTER_IO_CLASS_FILE_NAME "filter_io_class"
+
+#define IOTRACE_PROCFS_FILTER_LBA_FILE_NAME "filter_lba"
+
+#define IOTRACE_PROCFS_SAMPLING_FILE_NAME "sampling"
+
+#define IOTRACE_PROCFS_CLOCK_FILE_NAME "clock"
+
+#define IOTRACE_PROCFS_DROPS_FILE_NAME "drops"
+
+#define IOTRACE_PROCFS_SELFTEST_FILE_NAME "selftest"
+
 static const uint64_t iotrace_procfs_max_buffer_size_mb =
         4096; /** 4GiB max for all cpus */
 
@@ -5,6 +5,8 @@
 
 #include <linux/version.h>
 #include <linux/blkdev.h>
+#include <linux/hash.h>
+#include <linux/percpu.h>
 #include "internal/dss.h"
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 14, 0)
@@ -13,6 +15,30 @@
 #define SEGMENT_BVEC(vec) (vec)
 #endif
 
+#define DSS_CACHE_BITS 8
+#define DSS_CACHE_SIZE (1 << DSS_CACHE_BITS)
+
+/**
+ * @brief Memoized file size classification result
+ */
+struct iotrace_dss_cache_entry {
+	/** Classified inode */
+	struct inode *inode;
+
+	/** File size the tag was computed for */
+	loff_t size;
+
+	/** Cached DSS tag */
+	int tag;
+};
+
+/* Lockless per CPU classification cache. Entries are validated by file
+ * size, and the tag of a regular file depends on nothing but its size -
+ * so even a stale entry whose inode address got reused yields the
+ * correct tag whenever the size matches. */
+static DEFINE_PER_CPU(struct iotrace_dss_cache_entry[DSS_CACHE_SIZE],
+		      iotrace_dss_cache);
+
 /* DSS: tagging according to file sizes */
 static inline int iotrace_dss_file_size_tag(struct inode *inode)
 {
@@ -62,6 +88,40 @@ static inline int iotrace_dss_file_size_tag(struct inode *inode)
 	return tag;
 }
 
+/**
+ * @brief Classify regular file via per-cpu cache
+ *
+ * @usage This function is designed to be called with preemption disabled.
+ *
+ * @param inode inode of classified file
+ *
+ * @retval DSS tag
+ */
+static int iotrace_dss_file_size_tag_cached(struct inode *inode)
+{
+	struct iotrace_dss_cache_entry *entry;
+	loff_t size;
+	int tag;
+
+	if (!inode || !S_ISREG(inode->i_mode))
+		return iotrace_dss_file_size_tag(inode);
+
+	size = i_size_read(inode);
+
+	entry = this_cpu_ptr(
+		&iotrace_dss_cache[hash_ptr(inode, DSS_CACHE_BITS)]);
+	if (entry->inode == inode && entry->size == size)
+		return entry->tag;
+
+	tag = iotrace_dss_file_size_tag(inode);
+
+	entry->inode = inode;
+	entry->size = size;
+	entry->tag = tag;
+
+	return tag;
+}
+
 int iotrace_dss_bio_io_class(struct bio *bio)
 {
 	/* Try get inode of block device */
@@ -110,5 +170,5 @@ int iotrace_dss_bio_io_class(struct bio *bio)
 		return DSS_METADATA;
 	}
 
-	return iotrace_dss_file_size_tag(bio_inode);
+	return iotrace_dss_file_size_tag_cached(bio_inode);
 }
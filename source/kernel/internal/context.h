@@ -24,9 +24,14 @@ struct iotrace_context {
     /** Tracing state (seq no etc) */
     struct iotrace_state trace_state;
 
-    /** Log buffer size */
+    /** Log buffer size (per CPU, in bytes) */
     uint64_t size;
 
+    /** Requested total buffer size in MiB, as written to the size file;
+     *  reported back unrounded so userspace can detect an unchanged
+     *  request and skip rebuilding the ring pool */
+    uint64_t size_mb;
+
     /** Buffer which holds module version */
     char *version_buff;
 
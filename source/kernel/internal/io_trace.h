@@ -6,11 +6,53 @@
 #ifndef SOURCE_KERNEL_INTERNAL_IO_TRACE_H
 #define SOURCE_KERNEL_INTERNAL_IO_TRACE_H
 
+#include <linux/timer.h>
 #include "internal/dss.h"
 #include "trace.h"
 
 struct iotrace_context;
 
+/* Operation filter mask bits */
+#define IOTRACE_FILTER_OP_RD (1 << 0)
+#define IOTRACE_FILTER_OP_WR (1 << 1)
+#define IOTRACE_FILTER_OP_DISCARD (1 << 2)
+#define IOTRACE_FILTER_OP_ALL \
+    (IOTRACE_FILTER_OP_RD | IOTRACE_FILTER_OP_WR | IOTRACE_FILTER_OP_DISCARD)
+
+/**
+ * @brief Timestamp sources selectable for the bio probes
+ */
+enum iotrace_clock_source {
+    /** ktime_get - fully corrected monotonic clock, the safe default */
+    iotrace_clock_ktime = 0,
+
+    /** sched_clock - raw local clock (TSC backed on stable hosts),
+     *  roughly half the per-event header cost of ktime_get */
+    iotrace_clock_sched = 1,
+};
+
+/**
+ * @brief Event filter evaluated in the bio probe
+ *
+ * Events rejected by the filter are dropped before they are built, so
+ * filtering costs nothing but the predicate itself. Fields are read
+ * unlocked on the hot path; writers update one plain word at a time,
+ * so a racing bio sees either the old or the new setting.
+ */
+struct iotrace_io_filter {
+    /** Mask of traced operations (IOTRACE_FILTER_OP_*) */
+    uint32_t ops;
+
+    /** Bit per traced DSS io class (bit n = class n) */
+    uint64_t io_class_map;
+
+    /** First traced sector */
+    uint64_t lba_start;
+
+    /** End of traced range (exclusive) */
+    uint64_t lba_end;
+};
+
 /**
  * @brief Global tracing state
  */
@@ -18,14 +60,47 @@ struct iotrace_state {
     /** iotrace per CPU objects */
     octf_trace_t __percpu *traces;
 
-    /** Sequential number */
-    atomic64_t sid;
+    /** Per CPU sequential number - events of one CPU stream are numbered
+     *  independently so the hot path never touches a shared cacheline;
+     *  streams are merged by timestamp and per-stream sid when parsed */
+    uint64_t __percpu *sid;
 
     /** Mutex for client attach / detach */
     struct mutex client_mutex;
 
     /* Number od attached clients */
     unsigned clients;
+
+    /** Number of events to accumulate before waking consumers */
+    uint64_t notify_watermark;
+
+    /** Per CPU count of events pushed since last consumer wakeup */
+    atomic64_t __percpu *notify_pending;
+
+    /** Periodic timer flushing pending wakeups of low-rate CPUs */
+    struct timer_list flush_timer;
+
+    /** Event filter applied in the bio probe */
+    struct iotrace_io_filter filter;
+
+    /** Trace every N-th bio of a CPU (1 disables sampling) */
+    uint32_t sampling_ratio;
+
+    /** Per CPU count of bios skipped since last sampled one */
+    uint32_t __percpu *sampling_cnt;
+
+    /** Per CPU count of events dropped on ring overflow; written only
+     *  by the owning CPU, read cross-CPU by the stats procfs file */
+    uint64_t __percpu *lost_events;
+
+    /** Timestamp source used by the probes, fixed for a capture */
+    enum iotrace_clock_source clock_source;
+
+    /** Calibration pair captured at attach - readings of the selected
+     *  source and of CLOCK_REALTIME taken back to back, letting the
+     *  parsing path normalize raw timestamps */
+    uint64_t clock_calib_raw;
+    uint64_t clock_calib_real;
 };
 
 int iotrace_trace_init(struct iotrace_context *iotrace);
@@ -42,6 +117,46 @@ int iotrace_trace_desc(struct iotrace_context *iotrace,
                        const char *dev_name,
                        uint64_t dev_size);
 
+int iotrace_set_filter_ops(struct iotrace_context *iotrace, uint32_t ops);
+
+uint32_t iotrace_get_filter_ops(struct iotrace_context *iotrace);
+
+int iotrace_set_filter_io_class(struct iotrace_context *iotrace, uint64_t map);
+
+uint64_t iotrace_get_filter_io_class(struct iotrace_context *iotrace);
+
+int iotrace_set_filter_lba(struct iotrace_context *iotrace,
+                           uint64_t start,
+                           uint64_t end);
+
+void iotrace_get_filter_lba(struct iotrace_context *iotrace,
+                            uint64_t *start,
+                            uint64_t *end);
+
+int iotrace_set_notify_watermark(struct iotrace_context *iotrace,
+                                 uint64_t watermark);
+
+uint64_t iotrace_get_notify_watermark(struct iotrace_context *iotrace);
+
+int iotrace_set_sampling_ratio(struct iotrace_context *iotrace,
+                               uint32_t ratio);
+
+uint32_t iotrace_get_sampling_ratio(struct iotrace_context *iotrace);
+
+int iotrace_set_clock_source(struct iotrace_context *iotrace,
+                             enum iotrace_clock_source source);
+
+enum iotrace_clock_source iotrace_get_clock_source(
+        struct iotrace_context *iotrace);
+
+void iotrace_get_clock_calibration(struct iotrace_context *iotrace,
+                                   uint64_t *raw,
+                                   uint64_t *real);
+
+uint64_t iotrace_get_lost_count(struct iotrace_context *iotrace, unsigned cpu);
+
+int iotrace_selftest(struct iotrace_context *iotrace, uint64_t *avg_ns);
+
 int iotrace_attach_client(struct iotrace_context *iotrace);
 
 void iotrace_detach_client(struct iotrace_context *iotrace);
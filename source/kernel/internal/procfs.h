@@ -7,6 +7,7 @@
 #define SOURCE_KERNEL_INTERNAL_PROCFS_H
 
 #include <linux/kref.h>
+#include <linux/spinlock.h>
 #include "trace.h"
 
 struct iotrace_context;
@@ -17,6 +18,23 @@ struct iotrace_proc_file {
     void *trace_ring;
     octf_trace_hdr_t *consumer_hdr;
     uint64_t trace_ring_size;
+
+    /** Overflow spill area - colder second tier the producer falls back
+     *  to when the primary ring is full during a burst. Kernel internal,
+     *  never mapped to userspace; drained back into the ring once the
+     *  consumer catches up. */
+    void *spill;
+    uint64_t spill_size;
+
+    /** Monotonic byte positions into the spill area; head - tail is the
+     *  amount of spilled data pending a drain */
+    uint64_t spill_head;
+    uint64_t spill_tail;
+
+    /** Protects spill positions - producer and drain touch the spill
+     *  only on the overflow path, so the lock is off the hot path */
+    spinlock_t spill_lock;
+
     bool inited;
     wait_queue_head_t poll_wait_queue;
 };
@@ -26,6 +44,7 @@ int iotrace_procfs_init(struct iotrace_context *iotrace);
 void iotrace_procfs_deinit(struct iotrace_context *iotrace);
 
 int iotrace_procfs_trace_file_alloc(struct iotrace_proc_file *proc_file,
-                                    uint64_t size);
+                                    uint64_t size,
+                                    unsigned cpu);
 
 #endif  // SOURCE_KERNEL_INTERNAL_PROCFS_H
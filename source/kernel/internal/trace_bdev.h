@@ -8,9 +8,14 @@
 
 #include <linux/blkdev.h>
 #include <linux/genhd.h>
+#include <linux/hash.h>
 
 #define SATRACE_MAX_DEVICES 16
 
+/* Open addressed queue lookup table, kept at most 1/4 full */
+#define IOTRACE_BDEV_HASH_BITS 6
+#define IOTRACE_BDEV_HASH_SIZE (1 << IOTRACE_BDEV_HASH_BITS)
+
 /**
  * @brief Traced devices info
  */
@@ -24,6 +29,11 @@ struct iotrace_bdev {
     /** Array of traced devices ptrs (per-cpu variable ) */
     struct block_device *__percpu *list;
 
+    /** Open addressed hash of traced request queue ptrs (per-cpu
+     *  variable), so the bio probe resolves membership in O(1) instead
+     *  of scanning the device array for every bio on the system */
+    struct request_queue *__percpu *lookup;
+
     /** number of traced devices - only for use in  management path
      *  as different CPUs might have different number of bdevs in
      *  bdev_list while management operation is in progress */
@@ -33,6 +43,10 @@ struct iotrace_bdev {
 /**
  * @brief Check if device with given queue is added to trace list
  *
+ * Probes the per-cpu queue hash; for the common case of a bio to an
+ * untraced device the first probed slot is empty and the check costs
+ * a couple of loads.
+ *
  * @usage This function is designed to be called with preemption disabled.
  *
  * @param trace_bdev iotrace device list
@@ -42,14 +56,19 @@ struct iotrace_bdev {
 static bool inline iotrace_bdev_is_added(struct iotrace_bdev *trace_bdev,
                                          unsigned cpu,
                                          struct request_queue *q) {
-    struct block_device **bdev_list;
+    struct request_queue **lookup = per_cpu_ptr(trace_bdev->lookup, cpu);
+    unsigned slot = hash_ptr(q, IOTRACE_BDEV_HASH_BITS);
     unsigned i;
 
-    bdev_list = per_cpu_ptr(trace_bdev->list, cpu);
+    for (i = 0; i < IOTRACE_BDEV_HASH_SIZE; i++) {
+        struct request_queue *entry = lookup[slot];
 
-    for (i = 0; i < SATRACE_MAX_DEVICES && bdev_list[i] != NULL; i++) {
-        if (bdev_list[i]->bd_queue == q)
+        if (entry == q)
             return true;
+        if (!entry)
+            return false;
+
+        slot = (slot + 1) & (IOTRACE_BDEV_HASH_SIZE - 1);
     }
 
     return false;
@@ -58,9 +77,9 @@ static bool inline iotrace_bdev_is_added(struct iotrace_bdev *trace_bdev,
 int iotrace_bdev_list(struct iotrace_bdev *trace_bdev,
                       char list[SATRACE_MAX_DEVICES][DISK_NAME_LEN]);
 
-int iotrace_bdev_remove(struct iotrace_bdev *trace_bdev, char *path);
+int iotrace_bdev_remove(struct iotrace_bdev *trace_bdev, char *paths);
 
-int iotrace_bdev_add(struct iotrace_bdev *trace_bdev, char *path);
+int iotrace_bdev_add(struct iotrace_bdev *trace_bdev, char *paths);
 
 void iotrace_bdev_remove_all(struct iotrace_bdev *trace_bdev);
 
@@ -4,6 +4,8 @@
  */
 
 #include <linux/types.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
 #include <linux/wait.h>
 #include <linux/tracepoint.h>
 #include <trace/events/block.h>
@@ -13,6 +15,7 @@
 #include "internal/bio.h"
 #include "internal/procfs.h"
 #include "iotrace_event.h"
+#include "iotrace_event_completion.h"
 #include "trace.h"
 #include "procfs_files.h"
 
@@ -20,13 +23,386 @@
 /* Maximal length of buffer with version information */
 #define VERSION_BUFFER_MAX_LEN 64
 
+/* Default number of events accumulated before consumers are woken */
+#define NOTIFY_WATERMARK_DEFAULT 128
+/* Upper bound sanity limit for the watermark */
+#define NOTIFY_WATERMARK_MAX (1024ULL * 1024ULL)
+/* Period of the timer flushing pending wakeups of low-rate CPUs */
+#define NOTIFY_FLUSH_INTERVAL_MS 100
+
+/**
+ * @brief Read the configured timestamp source
+ *
+ * Taken once per event, so the cost of the clock read is a visible part
+ * of the probe profile. sched_clock is substantially cheaper than
+ * ktime_get on TSC stable hosts; its raw readings are normalized by the
+ * parsing path using the calibration pair captured at attach.
+ *
+ * @param state iotrace state
+ *
+ * @return timestamp in ns of the selected source
+ */
+static inline uint64_t iotrace_timestamp(struct iotrace_state *state)
+{
+	if (state->clock_source == iotrace_clock_sched)
+		return sched_clock();
+
+	return ktime_to_ns(ktime_get());
+}
+
 static inline void iotrace_notify_of_new_events(struct iotrace_context *context,
 						unsigned int cpu)
 {
-	wait_queue_head_t *queue =
-		&(per_cpu_ptr(context->proc_files, cpu)->poll_wait_queue);
+	struct iotrace_state *state = &context->trace_state;
+	atomic64_t *pending = per_cpu_ptr(state->notify_pending, cpu);
+	octf_trace_t trace = *per_cpu_ptr(state->traces, cpu);
+
+	/* Waking consumers on every single event taxes the traced workload,
+	 * so defer the wakeup until enough events accumulated. A nearly full
+	 * ring is flushed immediately regardless of the watermark, and the
+	 * flush timer picks up whatever low-rate CPUs leave behind. */
+	if ((uint64_t) atomic64_inc_return(pending) < state->notify_watermark &&
+	    !octf_trace_is_almost_full(trace))
+		return;
+
+	atomic64_set(pending, 0);
+	wake_up(&(per_cpu_ptr(context->proc_files, cpu)->poll_wait_queue));
+}
+
+/**
+ * @brief Wake consumers of all CPUs with events pending since last wakeup
+ *
+ * Ensures rings of low-rate devices are drained promptly even when the
+ * notify watermark is never reached.
+ *
+ * @param data iotrace main context
+ */
+static void iotrace_notify_flush_timer_fn(unsigned long data)
+{
+	struct iotrace_context *context = (void *) data;
+	struct iotrace_state *state = &context->trace_state;
+	unsigned i;
+
+	for_each_online_cpu (i) {
+		atomic64_t *pending = per_cpu_ptr(state->notify_pending, i);
+
+		if (atomic64_xchg(pending, 0)) {
+			wake_up(&(per_cpu_ptr(context->proc_files, i)
+					  ->poll_wait_queue));
+		}
+	}
+
+	mod_timer(&state->flush_timer,
+		  jiffies + msecs_to_jiffies(NOTIFY_FLUSH_INTERVAL_MS));
+}
+
+/**
+ * @brief Set consumer wakeup watermark
+ *
+ * @param iotrace iotrace context
+ * @param watermark number of events accumulated on a CPU before its
+ *	  consumer is woken (1 restores wakeup per event)
+ *
+ * @retval 0 Watermark set successfully
+ * @retval non-zero Error code
+ */
+int iotrace_set_notify_watermark(struct iotrace_context *iotrace,
+				 uint64_t watermark)
+{
+	if (watermark == 0 || watermark > NOTIFY_WATERMARK_MAX)
+		return -EINVAL;
+
+	iotrace->trace_state.notify_watermark = watermark;
+
+	return 0;
+}
+
+/**
+ * @brief Get consumer wakeup watermark
+ *
+ * @param iotrace iotrace context
+ *
+ * @return watermark value
+ */
+uint64_t iotrace_get_notify_watermark(struct iotrace_context *iotrace)
+{
+	return iotrace->trace_state.notify_watermark;
+}
+
+/**
+ * @brief Check whether bio passes the operation and LBA range filter
+ *
+ * Evaluated before the event is built, so filtered out I/O costs only
+ * this predicate on the hot path.
+ *
+ * @param filter event filter
+ * @param bio I/O description
+ *
+ * @retval true bio shall be traced
+ * @retval false bio is filtered out
+ */
+static bool iotrace_filter_match_bio(struct iotrace_io_filter *filter,
+				     struct bio *bio)
+{
+	uint64_t lba = IOTRACE_BIO_BISECTOR(bio);
+	uint64_t len = IOTRACE_BIO_BISIZE(bio) >> SECTOR_SHIFT;
+	uint32_t op;
+
+	if (IOTRACE_BIO_IS_DISCARD(bio))
+		op = IOTRACE_FILTER_OP_DISCARD;
+	else if (IOTRACE_BIO_IS_WRITE(bio))
+		op = IOTRACE_FILTER_OP_WR;
+	else
+		op = IOTRACE_FILTER_OP_RD;
+
+	if (!(filter->ops & op))
+		return false;
+
+	/* trace bio if it overlaps the configured range */
+	if (lba + len <= filter->lba_start || lba >= filter->lba_end)
+		return false;
+
+	return true;
+}
+
+/* Spill records are a size header followed by the payload */
+#define SPILL_REC_HDR_SIZE sizeof(uint32_t)
+
+/**
+ * @brief Append one event to the spill area
+ *
+ * Records are stored contiguously; when the leftover space at the buffer
+ * end cannot hold a whole record it is skipped (marked with a zero size
+ * header when the header itself still fits).
+ *
+ * @param proc_file procfs file description of the ring which overflowed
+ * @param data event to spill
+ * @param size event size
+ *
+ * @retval 0 Event spilled successfully
+ * @retval -ENOSPC Spill area is full as well, event is lost
+ */
+static int iotrace_spill_push(struct iotrace_proc_file *proc_file,
+			      const void *data, size_t size)
+{
+	uint64_t used, pos, at_end;
+	unsigned long flags;
+	int result = 0;
+
+	if (!proc_file->spill)
+		return -ENOSPC;
+
+	spin_lock_irqsave(&proc_file->spill_lock, flags);
+
+	used = proc_file->spill_head - proc_file->spill_tail;
+	pos = proc_file->spill_head % proc_file->spill_size;
+	at_end = proc_file->spill_size - pos;
+
+	if (at_end < SPILL_REC_HDR_SIZE + size) {
+		if (proc_file->spill_size - used < at_end) {
+			result = -ENOSPC;
+			goto unlock;
+		}
+		if (at_end >= SPILL_REC_HDR_SIZE)
+			*(uint32_t *) (proc_file->spill + pos) = 0;
+		proc_file->spill_head += at_end;
+		used += at_end;
+		pos = 0;
+	}
+
+	if (proc_file->spill_size - used < SPILL_REC_HDR_SIZE + size) {
+		result = -ENOSPC;
+		goto unlock;
+	}
+
+	*(uint32_t *) (proc_file->spill + pos) = size;
+	memcpy(proc_file->spill + pos + SPILL_REC_HDR_SIZE, data, size);
+	proc_file->spill_head += SPILL_REC_HDR_SIZE + size;
+
+unlock:
+	spin_unlock_irqrestore(&proc_file->spill_lock, flags);
+	return result;
+}
+
+/**
+ * @brief Move spilled events back into the primary ring
+ *
+ * Called from the producer on its own CPU, so pushes into the ring do not
+ * race the bio probes.
+ *
+ * @param proc_file procfs file description
+ * @param trace trace handle of the same CPU
+ *
+ * @retval true Spill fully drained (or empty)
+ * @retval false Ring filled up again before the spill emptied
+ */
+static bool iotrace_spill_drain(struct iotrace_proc_file *proc_file,
+				octf_trace_t trace)
+{
+	unsigned long flags;
+	bool drained = true;
+
+	if (!proc_file->spill ||
+	    proc_file->spill_tail == proc_file->spill_head)
+		return true;
+
+	spin_lock_irqsave(&proc_file->spill_lock, flags);
+
+	while (proc_file->spill_tail != proc_file->spill_head) {
+		uint64_t pos = proc_file->spill_tail % proc_file->spill_size;
+		uint64_t at_end = proc_file->spill_size - pos;
+		uint32_t size;
+
+		if (at_end < SPILL_REC_HDR_SIZE) {
+			proc_file->spill_tail += at_end;
+			continue;
+		}
+
+		size = *(uint32_t *) (proc_file->spill + pos);
+		if (!size) {
+			/* skip marker - rest of the buffer end is padding */
+			proc_file->spill_tail += at_end;
+			continue;
+		}
+
+		if (octf_trace_push(trace,
+				    proc_file->spill + pos + SPILL_REC_HDR_SIZE,
+				    size)) {
+			drained = false;
+			break;
+		}
+
+		proc_file->spill_tail += SPILL_REC_HDR_SIZE + size;
+	}
+
+	spin_unlock_irqrestore(&proc_file->spill_lock, flags);
+	return drained;
+}
+
+/**
+ * @brief Count and discard events left in the spill area
+ *
+ * Used when the capture ends - whatever the consumer never got a chance
+ * to see goes into the lost event accounting instead of vanishing.
+ *
+ * @param proc_file procfs file description
+ *
+ * @return number of discarded events
+ */
+static uint64_t iotrace_spill_purge(struct iotrace_proc_file *proc_file)
+{
+	unsigned long flags;
+	uint64_t count = 0;
+
+	if (!proc_file->spill)
+		return 0;
+
+	spin_lock_irqsave(&proc_file->spill_lock, flags);
+
+	while (proc_file->spill_tail != proc_file->spill_head) {
+		uint64_t pos = proc_file->spill_tail % proc_file->spill_size;
+		uint64_t at_end = proc_file->spill_size - pos;
+		uint32_t size;
+
+		if (at_end < SPILL_REC_HDR_SIZE) {
+			proc_file->spill_tail += at_end;
+			continue;
+		}
+
+		size = *(uint32_t *) (proc_file->spill + pos);
+		if (!size) {
+			proc_file->spill_tail += at_end;
+			continue;
+		}
+
+		proc_file->spill_tail += SPILL_REC_HDR_SIZE + size;
+		count++;
+	}
+
+	spin_unlock_irqrestore(&proc_file->spill_lock, flags);
+	return count;
+}
+
+/**
+ * @brief Push event to the trace ring, overflowing into the spill area
+ *
+ * Events pending in the spill are moved back first, which both keeps the
+ * per CPU stream ordered by sid and makes the spill self draining - the
+ * next traced bio after the consumer catches up empties it.
+ *
+ * @param context iotrace main context
+ * @param cpu CPU id
+ * @param data event to push
+ * @param size event size
+ */
+static void iotrace_push_event(struct iotrace_context *context, unsigned cpu,
+			       const void *data, size_t size)
+{
+	struct iotrace_state *state = &context->trace_state;
+	struct iotrace_proc_file *proc_file =
+		per_cpu_ptr(context->proc_files, cpu);
+	octf_trace_t trace = *per_cpu_ptr(state->traces, cpu);
+
+	if (!iotrace_spill_drain(proc_file, trace) ||
+	    octf_trace_push(trace, data, size)) {
+		/* ring congested - second tier absorbs the burst */
+		if (iotrace_spill_push(proc_file, data, size))
+			(*per_cpu_ptr(state->lost_events, cpu))++;
+	}
+}
+
+/**
+ * @brief Build an IO event describing given bio
+ *
+ * Shared by the bio probe and the procfs self test, so the self test
+ * measures exactly the event construction the probe performs.
+ *
+ * @param state iotrace state
+ * @param cpu CPU id
+ * @param dev_id Device id
+ * @param bio I/O description
+ * @param[out] ev zeroed event to fill
+ *
+ * @retval true Event built
+ * @retval false bio is filtered out
+ */
+static bool iotrace_build_io_event(struct iotrace_state *state, unsigned cpu,
+				   uint64_t dev_id, struct bio *bio,
+				   struct iotrace_event *ev)
+{
+	uint64_t sid;
+	int io_class;
+
+	if (!iotrace_filter_match_bio(&state->filter, bio))
+		return false;
+
+	io_class = iotrace_dss_bio_io_class(bio);
+	if (!(state->filter.io_class_map & (1ULL << io_class)))
+		return false;
+
+	sid = ++(*per_cpu_ptr(state->sid, cpu));
 
-	wake_up(queue);
+	iotrace_event_init_hdr(&ev->hdr, iotrace_event_type_io, sid,
+			  iotrace_timestamp(state), sizeof(*ev));
+
+	if (IOTRACE_BIO_IS_DISCARD(bio))
+		ev->operation = iotrace_event_operation_discard;
+	else if (IOTRACE_BIO_IS_WRITE(bio))
+		ev->operation = iotrace_event_operation_wr;
+	else
+		ev->operation = iotrace_event_operation_rd;
+
+	if (IOTRACE_BIO_IS_FLUSH(bio))
+		ev->flags |= iotrace_event_flag_flush;
+	if (IOTRACE_BIO_IS_FUA(bio))
+		ev->flags |= iotrace_event_flag_fua;
+
+	ev->lba = IOTRACE_BIO_BISECTOR(bio);
+	ev->len = IOTRACE_BIO_BISIZE(bio) >> SECTOR_SHIFT;
+	ev->io_class = io_class;
+	ev->dev_id = dev_id;
+
+	return true;
 }
 
 /**
@@ -45,33 +421,132 @@ static void iotrace_trace_bio(struct iotrace_context *context, unsigned cpu,
 {
 	struct iotrace_event ev = {};
 	struct iotrace_state *state = &context->trace_state;
-	uint64_t sid = atomic64_inc_return(&state->sid);
 
-	iotrace_event_init_hdr(&ev.hdr, iotrace_event_type_io, sid,
-			  ktime_to_ns(ktime_get()), sizeof(ev));
+	if (!iotrace_build_io_event(state, cpu, dev_id, bio, &ev))
+		return;
 
-	if (IOTRACE_BIO_IS_DISCARD(bio))
-		ev.operation = iotrace_event_operation_discard;
-	else if (IOTRACE_BIO_IS_WRITE(bio))
-		ev.operation = iotrace_event_operation_wr;
-	else
-		ev.operation = iotrace_event_operation_rd;
+	iotrace_push_event(context, cpu, &ev, sizeof(ev));
 
-	if (IOTRACE_BIO_IS_FLUSH(bio))
-		ev.flags |= iotrace_event_flag_flush;
-	if (IOTRACE_BIO_IS_FUA(bio))
-		ev.flags |= iotrace_event_flag_fua;
+	iotrace_notify_of_new_events(context, cpu);
+}
+
+/**
+ * @brief Write I/O completion information to trace buffer
+ *
+ * @param context iotrace main context
+ * @param cpu CPU id
+ * @param dev_id Device id
+ * @param bio completed I/O description
+ * @param error completion result
+ */
+static void iotrace_trace_bio_cmpl(struct iotrace_context *context,
+				   unsigned cpu, uint64_t dev_id,
+				   struct bio *bio, int error)
+{
+	struct iotrace_event_completion ev = {};
+	struct iotrace_state *state = &context->trace_state;
+	uint64_t sid;
+
+	if (!iotrace_filter_match_bio(&state->filter, bio))
+		return;
 
+	sid = ++(*per_cpu_ptr(state->sid, cpu));
+
+	iotrace_event_init_hdr(&ev.hdr, IOTRACE_EVENT_TYPE_IO_COMPLETION, sid,
+			  iotrace_timestamp(state), sizeof(ev));
+
+	/* Sector and size at completion describe the completed region;
+	 * drivers advancing the bio report the residual, same as blktrace */
 	ev.lba = IOTRACE_BIO_BISECTOR(bio);
 	ev.len = IOTRACE_BIO_BISIZE(bio) >> SECTOR_SHIFT;
-	ev.io_class = iotrace_dss_bio_io_class(bio);
+	ev.error = error;
 	ev.dev_id = dev_id;
 
-	octf_trace_push(*per_cpu_ptr(state->traces, cpu), &ev, sizeof(ev));
+	iotrace_push_event(context, cpu, &ev, sizeof(ev));
 
 	iotrace_notify_of_new_events(context, cpu);
 }
 
+/**
+ * @brief Set operation filter
+ *
+ * @param iotrace iotrace context
+ * @param ops mask of IOTRACE_FILTER_OP_* bits
+ *
+ * @retval 0 Filter set successfully
+ * @retval non-zero Error code
+ */
+int iotrace_set_filter_ops(struct iotrace_context *iotrace, uint32_t ops)
+{
+	if (ops == 0 || (ops & ~IOTRACE_FILTER_OP_ALL))
+		return -EINVAL;
+
+	iotrace->trace_state.filter.ops = ops;
+
+	return 0;
+}
+
+uint32_t iotrace_get_filter_ops(struct iotrace_context *iotrace)
+{
+	return iotrace->trace_state.filter.ops;
+}
+
+/**
+ * @brief Set io class filter
+ *
+ * @param iotrace iotrace context
+ * @param map bitmap with bit n set for each traced DSS io class n
+ *
+ * @retval 0 Filter set successfully
+ * @retval non-zero Error code
+ */
+int iotrace_set_filter_io_class(struct iotrace_context *iotrace, uint64_t map)
+{
+	if (map == 0)
+		return -EINVAL;
+
+	iotrace->trace_state.filter.io_class_map = map;
+
+	return 0;
+}
+
+uint64_t iotrace_get_filter_io_class(struct iotrace_context *iotrace)
+{
+	return iotrace->trace_state.filter.io_class_map;
+}
+
+/**
+ * @brief Set LBA range filter
+ *
+ * @param iotrace iotrace context
+ * @param start first traced sector
+ * @param end end of traced range, exclusive (0 selects whole device)
+ *
+ * @retval 0 Filter set successfully
+ * @retval non-zero Error code
+ */
+int iotrace_set_filter_lba(struct iotrace_context *iotrace, uint64_t start,
+			   uint64_t end)
+{
+	if (end == 0)
+		end = UINT64_MAX;
+
+	if (start >= end)
+		return -EINVAL;
+
+	iotrace->trace_state.filter.lba_start = start;
+	iotrace->trace_state.filter.lba_end = end;
+
+	return 0;
+}
+
+void iotrace_get_filter_lba(struct iotrace_context *iotrace, uint64_t *start,
+			    uint64_t *end)
+{
+	*start = iotrace->trace_state.filter.lba_start;
+	*end = iotrace->trace_state.filter.lba_end;
+}
+
 /**
  * @brief Write device information to trace buffer
  *
@@ -91,7 +566,7 @@ int iotrace_trace_desc(struct iotrace_context *iotrace, unsigned cpu,
 	octf_trace_t trace = *per_cpu_ptr(state->traces, cpu);
 
 	struct iotrace_event_device_desc desc;
-	uint64_t sid = atomic64_inc_return(&state->sid);
+	uint64_t sid = ++(*per_cpu_ptr(state->sid, cpu));
 	const size_t dev_name_size = sizeof(desc.device_name);
 
 	if (strnlen(dev_name, dev_name_size) >= dev_name_size)
@@ -99,7 +574,7 @@ int iotrace_trace_desc(struct iotrace_context *iotrace, unsigned cpu,
 	strcpy(desc.device_name, dev_name);
 
 	iotrace_event_init_hdr(&desc.hdr, iotrace_event_type_device_desc, sid,
-			  ktime_to_ns(ktime_get()), sizeof(desc));
+			  iotrace_timestamp(state), sizeof(desc));
 
 	desc.id = dev_id;
 	desc.device_size = dev_size;
@@ -125,17 +600,229 @@ static void bio_queue_event(void *ignore, struct request_queue *q,
 	uint32_t dev_id;
 	unsigned cpu = get_cpu();
 	struct iotrace_context *iotrace = iotrace_get_context();
+	struct iotrace_state *state = &iotrace->trace_state;
 
 	if (iotrace_bdev_is_added(&iotrace->bdev, cpu, q)) {
+		/* When sampling, trace every N-th bio seen on this CPU.
+		 * Counter-based selection keeps the sample unbiased for
+		 * any per-CPU arrival pattern at negligible cost. */
+		if (state->sampling_ratio > 1) {
+			uint32_t *cnt = per_cpu_ptr(state->sampling_cnt, cpu);
+
+			if (++(*cnt) < state->sampling_ratio)
+				goto exit;
+			*cnt = 0;
+		}
+
 		dev_id = disk_devt(bio->bi_bdev->bd_disk);
 		iotrace_trace_bio(iotrace, cpu, dev_id, bio);
 	}
 
+exit:
+	put_cpu();
+
+	return;
+}
+
+/**
+ * @brief Function registered to be called each time BIO completes
+ *
+ * Completion events pair with submissions through device id, LBA and
+ * length. Sampling intentionally does not apply here - a sampled subset
+ * of completions would not correlate with the sampled submissions.
+ *
+ * @param ignore Ignore this param
+ * @param q Associated request queue
+ * @param bio completed I/O description
+ * @param error completion result
+ */
+static void bio_complete_event(void *ignore, struct request_queue *q,
+			       struct bio *bio, int error)
+{
+	uint32_t dev_id;
+	unsigned cpu = get_cpu();
+	struct iotrace_context *iotrace = iotrace_get_context();
+
+	if (iotrace_bdev_is_added(&iotrace->bdev, cpu, q)) {
+		dev_id = disk_devt(bio->bi_bdev->bd_disk);
+		iotrace_trace_bio_cmpl(iotrace, cpu, dev_id, bio, error);
+	}
+
 	put_cpu();
 
 	return;
 }
 
+/**
+ * @brief Set sampling ratio
+ *
+ * @param iotrace iotrace context
+ * @param ratio trace one in @ratio bios per CPU (1 traces everything)
+ *
+ * @retval 0 Ratio set successfully
+ * @retval non-zero Error code
+ */
+int iotrace_set_sampling_ratio(struct iotrace_context *iotrace, uint32_t ratio)
+{
+	if (ratio == 0)
+		return -EINVAL;
+
+	iotrace->trace_state.sampling_ratio = ratio;
+
+	return 0;
+}
+
+uint32_t iotrace_get_sampling_ratio(struct iotrace_context *iotrace)
+{
+	return iotrace->trace_state.sampling_ratio;
+}
+
+/**
+ * @brief Set probe timestamp source
+ *
+ * @param iotrace iotrace context
+ * @param source clock source used for event timestamps
+ *
+ * @retval 0 Source set successfully
+ * @retval -EBUSY A capture is running - all events of one trace have to
+ *	   come from one clock, so the source is fixed at attach
+ * @retval non-zero Error code
+ */
+int iotrace_set_clock_source(struct iotrace_context *iotrace,
+			     enum iotrace_clock_source source)
+{
+	struct iotrace_state *state = &iotrace->trace_state;
+	int result = 0;
+
+	if (source != iotrace_clock_ktime && source != iotrace_clock_sched)
+		return -EINVAL;
+
+	mutex_lock(&state->client_mutex);
+
+	if (state->clients)
+		result = -EBUSY;
+	else
+		state->clock_source = source;
+
+	mutex_unlock(&state->client_mutex);
+	return result;
+}
+
+enum iotrace_clock_source iotrace_get_clock_source(
+	struct iotrace_context *iotrace)
+{
+	return iotrace->trace_state.clock_source;
+}
+
+/**
+ * @brief Get clock calibration pair of the current/last capture
+ *
+ * @param iotrace iotrace context
+ * @param[out] raw reading of the selected source at attach
+ * @param[out] real CLOCK_REALTIME ns taken at the same instant
+ */
+void iotrace_get_clock_calibration(struct iotrace_context *iotrace,
+				   uint64_t *raw, uint64_t *real)
+{
+	*raw = iotrace->trace_state.clock_calib_raw;
+	*real = iotrace->trace_state.clock_calib_real;
+}
+
+/**
+ * @brief Get number of events dropped on ring overflow on given CPU
+ *
+ * @param iotrace iotrace context
+ * @param cpu CPU id
+ *
+ * @return drop count since the trace buffers were last (re)initialized
+ */
+uint64_t iotrace_get_lost_count(struct iotrace_context *iotrace, unsigned cpu)
+{
+	return *per_cpu_ptr(iotrace->trace_state.lost_events, cpu);
+}
+
+/* Self test parameters - the ring holds all events, so the timed loop
+ * measures build + push without interleaved draining */
+#define SELFTEST_EVENTS 32768ULL
+#define SELFTEST_RING_SIZE (4ULL * 1024ULL * 1024ULL)
+
+/**
+ * @brief Measure the probe event path on fabricated bios
+ *
+ * Builds and pushes SELFTEST_EVENTS IO events into a private trace ring
+ * through the same code the bio probe runs, and reports the average
+ * cost per event. Gives a per-commit overhead number without attaching
+ * a real device or consumer.
+ *
+ * @param iotrace iotrace context
+ * @param[out] avg_ns average event cost in ns
+ *
+ * @retval 0 Self test completed
+ * @retval -EBUSY A capture is running
+ * @retval non-zero Error code
+ */
+int iotrace_selftest(struct iotrace_context *iotrace, uint64_t *avg_ns)
+{
+	struct iotrace_state *state = &iotrace->trace_state;
+	octf_trace_hdr_t *hdr = NULL;
+	void *ring = NULL;
+	octf_trace_t trace = NULL;
+	struct bio *bio = NULL;
+	uint64_t begin, end, i;
+	unsigned cpu;
+	int result;
+
+	mutex_lock(&state->client_mutex);
+
+	if (state->clients) {
+		result = -EBUSY;
+		goto unlock;
+	}
+
+	ring = vmalloc(SELFTEST_RING_SIZE);
+	hdr = vzalloc(OCTF_TRACE_HDR_SIZE);
+	bio = kzalloc(sizeof(*bio), GFP_KERNEL);
+	if (!ring || !hdr || !bio) {
+		result = -ENOMEM;
+		goto cleanup;
+	}
+
+	result = octf_trace_open(ring, SELFTEST_RING_SIZE, hdr,
+				 octf_trace_open_mode_producer, &trace);
+	if (result)
+		goto cleanup;
+
+	/* 4 KiB reads - the common case the probe is optimized for. The
+	 * zeroed bio has no pages, classifying as DSS_UNCLASSIFIED. */
+	IOTRACE_BIO_BISIZE(bio) = 4096;
+
+	cpu = get_cpu();
+	begin = ktime_to_ns(ktime_get());
+
+	for (i = 0; i < SELFTEST_EVENTS; i++) {
+		struct iotrace_event ev = {};
+
+		IOTRACE_BIO_BISECTOR(bio) = i * 8;
+		if (iotrace_build_io_event(state, cpu, 0, bio, &ev))
+			octf_trace_push(trace, &ev, sizeof(ev));
+	}
+
+	end = ktime_to_ns(ktime_get());
+	put_cpu();
+
+	*avg_ns = (end - begin) / SELFTEST_EVENTS;
+
+	octf_trace_close(&trace);
+
+cleanup:
+	kfree(bio);
+	vfree(hdr);
+	vfree(ring);
+unlock:
+	mutex_unlock(&state->client_mutex);
+	return result;
+}
+
 /**
  * @brief Deinitialize iotrace tracers
  *
@@ -146,10 +833,17 @@ static void bio_queue_event(void *ignore, struct request_queue *q,
  */
 static void deinit_tracers(struct iotrace_state *state)
 {
+	struct iotrace_context *context = iotrace_get_context();
 	unsigned i;
 
-	for_each_online_cpu (i)
+	for_each_online_cpu (i) {
+		/* the consumer is gone - events still parked in the spill
+		 * area will never be seen and count as lost */
+		*per_cpu_ptr(state->lost_events, i) += iotrace_spill_purge(
+			per_cpu_ptr(context->proc_files, i));
+
 		octf_trace_close(per_cpu_ptr(state->traces, i));
+	}
 
 	free_percpu(state->traces);
 }
@@ -216,6 +910,7 @@ static int iotrace_set_buffer_size(struct iotrace_context *iotrace, uint64_t siz
 		return -EINVAL;
 
 	iotrace->size = size;
+	iotrace->size_mb = size_mb;
 
 	return 0;
 }
@@ -229,8 +924,10 @@ static int iotrace_set_buffer_size(struct iotrace_context *iotrace, uint64_t siz
  */
 uint64_t iotrace_get_buffer_size(struct iotrace_context *iotrace)
 {
-	return iotrace_get_context()->size * num_online_cpus() / 1024ULL /
-	       1024ULL;
+	/* Report the requested size, not one recomputed from the rounded
+	 * per-CPU portion - readback has to match what was written for the
+	 * userspace "skip unchanged size" check to work */
+	return iotrace_get_context()->size_mb;
 }
 
 /**
@@ -261,10 +958,14 @@ int iotrace_init_buffers(struct iotrace_context *iotrace, uint64_t size)
 	if (result)
 		goto exit;
 
+	/* fresh buffers - fresh completeness accounting */
+	for_each_online_cpu (i)
+		*per_cpu_ptr(state->lost_events, i) = 0;
+
 	for_each_online_cpu (i) {
 		file = per_cpu_ptr(proc_files, i);
 
-		result = iotrace_procfs_trace_file_alloc(file, iotrace->size);
+		result = iotrace_procfs_trace_file_alloc(file, iotrace->size, i);
 		if (result)
 			break;
 	}
@@ -289,6 +990,11 @@ int iotrace_attach_client(struct iotrace_context *iotrace)
 	mutex_lock(&state->client_mutex);
 
 	if (!state->clients) {
+		/* Calibrate the selected source against wall clock so the
+		 * parsing path can place raw timestamps in real time */
+		state->clock_calib_raw = iotrace_timestamp(state);
+		state->clock_calib_real = ktime_to_ns(ktime_get_real());
+
 		result = init_tracers(state, proc_files);
 		if (result)
 			goto exit;
@@ -300,7 +1006,24 @@ int iotrace_attach_client(struct iotrace_context *iotrace)
 			deinit_tracers(state);
 			goto exit;
 		}
+
+		result = register_trace_block_bio_complete(bio_complete_event,
+							   NULL);
+		if (result) {
+			printk(KERN_ERR "Failed to register completion trace "
+					"probe: %d\n",
+			       result);
+			unregister_trace_block_bio_queue(bio_queue_event,
+							 NULL);
+			deinit_tracers(state);
+			goto exit;
+		}
 		printk(KERN_INFO "Registered tracing callback\n");
+
+		/* start periodic flush of pending consumer wakeups */
+		mod_timer(&state->flush_timer,
+			  jiffies +
+				  msecs_to_jiffies(NOTIFY_FLUSH_INTERVAL_MS));
 	}
 
 	++state->clients;
@@ -327,7 +1050,11 @@ void iotrace_detach_client(struct iotrace_context *iotrace)
 		return;
 	}
 
-	/* unregister callback */
+	/* stop periodic wakeup flush */
+	del_timer_sync(&state->flush_timer);
+
+	/* unregister callbacks */
+	unregister_trace_block_bio_complete(bio_complete_event, NULL);
 	unregister_trace_block_bio_queue(bio_queue_event, NULL);
 	printk(KERN_INFO "Unregistered tracing callback\n");
 
@@ -355,11 +1082,62 @@ int iotrace_trace_init(struct iotrace_context *iotrace)
 	struct iotrace_state *state = &iotrace->trace_state;
 	mutex_init(&state->client_mutex);
 
+	state->sid = alloc_percpu(uint64_t);
+	if (!state->sid)
+		return -ENOMEM;
+
+	/* default filter passes everything */
+	state->filter.ops = IOTRACE_FILTER_OP_ALL;
+	state->filter.io_class_map = UINT64_MAX;
+	state->filter.lba_start = 0;
+	state->filter.lba_end = UINT64_MAX;
+
+	state->notify_watermark = NOTIFY_WATERMARK_DEFAULT;
+	state->notify_pending = alloc_percpu(atomic64_t);
+	if (!state->notify_pending) {
+		free_percpu(state->sid);
+		state->sid = NULL;
+		return -ENOMEM;
+	}
+
+	state->sampling_ratio = 1;
+	state->clock_source = iotrace_clock_ktime;
+	state->sampling_cnt = alloc_percpu(uint32_t);
+	if (!state->sampling_cnt) {
+		free_percpu(state->notify_pending);
+		state->notify_pending = NULL;
+		free_percpu(state->sid);
+		state->sid = NULL;
+		return -ENOMEM;
+	}
+
+	state->lost_events = alloc_percpu(uint64_t);
+	if (!state->lost_events) {
+		free_percpu(state->sampling_cnt);
+		state->sampling_cnt = NULL;
+		free_percpu(state->notify_pending);
+		state->notify_pending = NULL;
+		free_percpu(state->sid);
+		state->sid = NULL;
+		return -ENOMEM;
+	}
+
+	setup_timer(&state->flush_timer, iotrace_notify_flush_timer_fn,
+		    (unsigned long) iotrace);
+
 	/* Initialize buffer with version information */
 	iotrace->version_buff_size = VERSION_BUFFER_MAX_LEN;
 	iotrace->version_buff = vzalloc(iotrace->version_buff_size);
 	if (!iotrace->version_buff) {
 		iotrace->version_buff_size = 0;
+		free_percpu(state->lost_events);
+		state->lost_events = NULL;
+		free_percpu(state->sampling_cnt);
+		state->sampling_cnt = NULL;
+		free_percpu(state->notify_pending);
+		state->notify_pending = NULL;
+		free_percpu(state->sid);
+		state->sid = NULL;
 		return -ENOMEM;
 	}
 
@@ -377,6 +1155,26 @@ int iotrace_trace_init(struct iotrace_context *iotrace)
  */
 void iotrace_trace_deinit(struct iotrace_context *iotrace)
 {
+	if (iotrace->trace_state.lost_events) {
+		free_percpu(iotrace->trace_state.lost_events);
+		iotrace->trace_state.lost_events = NULL;
+	}
+
+	if (iotrace->trace_state.sampling_cnt) {
+		free_percpu(iotrace->trace_state.sampling_cnt);
+		iotrace->trace_state.sampling_cnt = NULL;
+	}
+
+	if (iotrace->trace_state.notify_pending) {
+		free_percpu(iotrace->trace_state.notify_pending);
+		iotrace->trace_state.notify_pending = NULL;
+	}
+
+	if (iotrace->trace_state.sid) {
+		free_percpu(iotrace->trace_state.sid);
+		iotrace->trace_state.sid = NULL;
+	}
+
 	if (iotrace->version_buff) {
 		vfree(iotrace->version_buff);
 		iotrace->version_buff = NULL;
@@ -12,6 +12,7 @@
 #include <linux/mm.h>
 #include <linux/uaccess.h>
 #include <linux/wait.h>
+#include <linux/workqueue.h>
 #include <linux/version.h>
 #include "internal/context.h"
 #include "internal/procfs.h"
@@ -30,9 +31,11 @@ static void _iotrace_free(struct kref *kref)
 
 	vfree(proc_file->trace_ring);
 	vfree(proc_file->consumer_hdr);
+	vfree(proc_file->spill);
 
 	proc_file->trace_ring = NULL;
 	proc_file->consumer_hdr = NULL;
+	proc_file->spill = NULL;
 }
 
 static int _iotrace_open(struct inode *inode, struct file *file)
@@ -147,6 +150,8 @@ static const struct vm_operations_struct _iotrace_vm_ops_consumer_hdr = {
 static int _iotrace_mmap_trace_ring(struct file *file,
 				     struct vm_area_struct *vma)
 {
+	struct iotrace_proc_file *proc_file = file->private_data;
+
 	/* do not allow write-mapping */
 	if (vma->vm_flags & VM_WRITE)
 		return -EPERM;
@@ -156,6 +161,15 @@ static int _iotrace_mmap_trace_ring(struct file *file,
 	if (file->f_mode & FMODE_WRITE)
 		return -EPERM;
 
+	/* Pre-populate the whole ring in one remap instead of taking a
+	 * fault per page when the consumer touches it - with large buffers
+	 * on many CPUs lazy faulting costs hundreds of thousands of faults
+	 * at attach time */
+	if (proc_file->trace_ring &&
+	    !remap_vmalloc_range(vma, proc_file->trace_ring, vma->vm_pgoff))
+		return 0;
+
+	/* Fall back to lazy faulting (e.g. partial mapping requested) */
 	vma->vm_ops = &_iotrace_vm_ops_trace_ring;
 
 	return 0;
@@ -164,6 +178,12 @@ static int _iotrace_mmap_trace_ring(struct file *file,
 static int _iotrace_mmap_consumer_hdr(struct file *file,
 				       struct vm_area_struct *vma)
 {
+	struct iotrace_proc_file *proc_file = file->private_data;
+
+	if (proc_file->consumer_hdr &&
+	    !remap_vmalloc_range(vma, proc_file->consumer_hdr, vma->vm_pgoff))
+		return 0;
+
 	vma->vm_ops = &_iotrace_vm_ops_consumer_hdr;
 	return 0;
 }
@@ -211,14 +231,16 @@ enum iotrace_dev_mng_op { iotrace_dev_add, iotrace_dev_remove };
 static ssize_t dev_mng_write(struct file *file, const char __user *ubuf,
 			     size_t count, loff_t *ppos, enum iotrace_dev_mng_op op)
 {
+	/* Newline separated list of up to SATRACE_MAX_DEVICES paths */
+	const size_t max_len = (size_t) PATH_MAX * SATRACE_MAX_DEVICES;
 	char *buf;
 	int result;
 	size_t len;
 
-	if (*ppos > 0 || count > PATH_MAX)
+	if (*ppos > 0 || count > max_len)
 		return -EFAULT;
 
-	buf = vzalloc(count);
+	buf = vzalloc(count + 1);
 	if (!buf)
 		return -ENOMEM;
 
@@ -227,8 +249,8 @@ static ssize_t dev_mng_write(struct file *file, const char __user *ubuf,
 		return -EFAULT;
 	}
 
-	len = strnlen(buf, PATH_MAX);
-	if (len >= PATH_MAX || len == 0) {
+	len = strnlen(buf, max_len);
+	if (len == 0) {
 		vfree(buf);
 		return -ENOSPC;
 	}
@@ -432,6 +454,543 @@ static ssize_t size_write(struct file *file, const char __user *ubuf,
 	return len;
 }
 
+static ssize_t watermark_read(struct file *file, char __user *ubuf,
+			      size_t count, loff_t *ppos)
+{
+	int pos;
+	char buf[size_file_max_count];
+	uint64_t watermark =
+		iotrace_get_notify_watermark(iotrace_get_context());
+
+	if (*ppos > 0)
+		return 0;
+
+	pos = snprintf(buf, sizeof(buf), "%llu", watermark);
+	if (pos < 0 || pos >= sizeof(buf))
+		return pos < 0 ? pos : -ENOSPC;
+
+	if (copy_to_user(ubuf, buf, pos + 1))
+		return -EFAULT;
+
+	*ppos = pos + 1;
+	return pos + 1;
+}
+
+static ssize_t watermark_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	char *buf;
+	int result;
+	size_t len;
+	unsigned long long watermark;
+
+	if (*ppos > 0 || count > size_file_max_count)
+		return -EFAULT;
+
+	buf = vzalloc(count);
+	if (!buf)
+		return -ENOMEM;
+
+	if (copy_from_user(buf, ubuf, count)) {
+		vfree(buf);
+		return -EFAULT;
+	}
+
+	len = strnlen(buf, size_file_max_count);
+	if (len == size_file_max_count || len == 0) {
+		vfree(buf);
+		return -ENOSPC;
+	}
+
+	result = kstrtou64(buf, 10, &watermark);
+
+	vfree(buf);
+
+	if (result)
+		return result;
+
+	result = iotrace_set_notify_watermark(iotrace_get_context(), watermark);
+	if (result)
+		return result;
+
+	return len;
+}
+
+static ssize_t sampling_read(struct file *file, char __user *ubuf,
+			     size_t count, loff_t *ppos)
+{
+	int pos;
+	char buf[size_file_max_count];
+	uint32_t ratio = iotrace_get_sampling_ratio(iotrace_get_context());
+
+	if (*ppos > 0)
+		return 0;
+
+	pos = snprintf(buf, sizeof(buf), "%u", ratio);
+	if (pos < 0 || pos >= sizeof(buf))
+		return pos < 0 ? pos : -ENOSPC;
+
+	if (copy_to_user(ubuf, buf, pos + 1))
+		return -EFAULT;
+
+	*ppos = pos + 1;
+	return pos + 1;
+}
+
+static ssize_t sampling_write(struct file *file, const char __user *ubuf,
+			      size_t count, loff_t *ppos)
+{
+	char *buf;
+	int result;
+	size_t len;
+	unsigned ratio;
+
+	if (*ppos > 0 || count > size_file_max_count)
+		return -EFAULT;
+
+	buf = vzalloc(count);
+	if (!buf)
+		return -ENOMEM;
+
+	if (copy_from_user(buf, ubuf, count)) {
+		vfree(buf);
+		return -EFAULT;
+	}
+
+	len = strnlen(buf, size_file_max_count);
+	if (len == size_file_max_count || len == 0) {
+		vfree(buf);
+		return -ENOSPC;
+	}
+
+	result = kstrtouint(buf, 10, &ratio);
+
+	vfree(buf);
+
+	if (result)
+		return result;
+
+	result = iotrace_set_sampling_ratio(iotrace_get_context(), ratio);
+	if (result)
+		return result;
+
+	return len;
+}
+
+/**
+ * @brief Read handler for file used to report per CPU dropped event counts
+ *
+ * Prints one "<cpu> <count>" line per online CPU. Counters reset when
+ * trace buffers are (re)initialized, so every capture reads its own
+ * completeness data.
+ *
+ * @param[in] file file object associated with this procfs entry
+ * @param[out] ubuf user pointer to output buffer
+ * @param[in] count ubuf size
+ * @param[out] ppos position in file after read operation is completed
+ *
+ * @retval number of bytes written to @ubuf
+ */
+static ssize_t drops_read(struct file *file, char __user *ubuf, size_t count,
+			  loff_t *ppos)
+{
+	char *buf;
+	int pos = 0;
+	unsigned i;
+	size_t buf_size;
+
+	if (*ppos > 0)
+		return 0;
+
+	/* one "<cpu> <count>\n" line is at most 32 bytes */
+	buf_size = 32 * num_online_cpus() + 1;
+	buf = vzalloc(buf_size);
+	if (!buf)
+		return -ENOMEM;
+
+	for_each_online_cpu (i) {
+		pos += snprintf(buf + pos, buf_size - pos, "%u %llu\n", i,
+				iotrace_get_lost_count(iotrace_get_context(),
+						       i));
+		if (pos >= buf_size) {
+			vfree(buf);
+			return -ENOSPC;
+		}
+	}
+
+	pos = min((size_t) pos + 1, count);
+
+	if (copy_to_user(ubuf, buf, pos)) {
+		vfree(buf);
+		return -EFAULT;
+	}
+
+	vfree(buf);
+
+	*ppos = pos;
+	return pos;
+}
+
+/**
+ * @brief Read handler for the probe self test file
+ *
+ * Each read runs the probe micro benchmark and prints its result as
+ * "<avg> ns/event" - a per-commit overhead number obtainable without
+ * attaching a device or consumer.
+ */
+static ssize_t selftest_read(struct file *file, char __user *ubuf, size_t count,
+			     loff_t *ppos)
+{
+	char buf[32];
+	int pos;
+	uint64_t avg_ns;
+	int result;
+
+	if (*ppos > 0)
+		return 0;
+
+	result = iotrace_selftest(iotrace_get_context(), &avg_ns);
+	if (result)
+		return result;
+
+	pos = snprintf(buf, sizeof(buf), "%llu ns/event\n", avg_ns);
+	if (pos < 0 || pos >= sizeof(buf))
+		return pos < 0 ? pos : -ENOSPC;
+
+	if (copy_to_user(ubuf, buf, pos + 1))
+		return -EFAULT;
+
+	*ppos = pos + 1;
+	return pos + 1;
+}
+
+static const size_t filter_file_max_count = 256;
+
+/**
+ * @brief Copy small text payload written to a filter file into kernel buffer
+ *
+ * Trailing newline is stripped.
+ *
+ * @param[in] ubuf user pointer to input buffer
+ * @param[in] count ubuf size
+ * @param[out] buf vzalloc-ed NULL terminated copy, to be vfree-d by caller
+ *
+ * @retval >0 payload length
+ * @retval <0 error code
+ */
+static ssize_t filter_write_copy(const char __user *ubuf, size_t count,
+				 char **buf)
+{
+	char *kbuf;
+	size_t len;
+
+	if (count == 0 || count > filter_file_max_count)
+		return -EFAULT;
+
+	kbuf = vzalloc(count + 1);
+	if (!kbuf)
+		return -ENOMEM;
+
+	if (copy_from_user(kbuf, ubuf, count)) {
+		vfree(kbuf);
+		return -EFAULT;
+	}
+
+	len = strnlen(kbuf, count);
+	if (len == 0) {
+		vfree(kbuf);
+		return -ENOSPC;
+	}
+
+	if (kbuf[len - 1] == '\n')
+		kbuf[--len] = '\0';
+
+	if (len == 0) {
+		vfree(kbuf);
+		return -ENOSPC;
+	}
+
+	*buf = kbuf;
+	return len;
+}
+
+/* Names indexed by enum iotrace_clock_source */
+static const char *const clock_source_names[] = { "ktime", "sched" };
+
+/**
+ * @brief Read handler for the probe timestamp source file
+ *
+ * Prints "<source> <source_ns> <realtime_ns>" - the calibration pair is
+ * captured at attach time and lets the parsing path normalize raw
+ * timestamps to real time.
+ */
+static ssize_t clock_read(struct file *file, char __user *ubuf, size_t count,
+			  loff_t *ppos)
+{
+	char buf[64];
+	int pos;
+	uint64_t raw, real;
+
+	if (*ppos > 0)
+		return 0;
+
+	iotrace_get_clock_calibration(iotrace_get_context(), &raw, &real);
+
+	pos = snprintf(buf, sizeof(buf), "%s %llu %llu\n",
+		       clock_source_names[iotrace_get_clock_source(
+			       iotrace_get_context())],
+		       raw, real);
+	if (pos < 0 || pos >= sizeof(buf))
+		return pos < 0 ? pos : -ENOSPC;
+
+	if (copy_to_user(ubuf, buf, pos + 1))
+		return -EFAULT;
+
+	*ppos = pos + 1;
+	return pos + 1;
+}
+
+static ssize_t clock_write(struct file *file, const char __user *ubuf,
+			   size_t count, loff_t *ppos)
+{
+	char *buf;
+	ssize_t len;
+	enum iotrace_clock_source source;
+	int result;
+
+	if (*ppos > 0)
+		return -EFAULT;
+
+	len = filter_write_copy(ubuf, count, &buf);
+	if (len < 0)
+		return len;
+
+	if (!strcmp(buf, clock_source_names[iotrace_clock_ktime])) {
+		source = iotrace_clock_ktime;
+	} else if (!strcmp(buf, clock_source_names[iotrace_clock_sched])) {
+		source = iotrace_clock_sched;
+	} else {
+		vfree(buf);
+		return -EINVAL;
+	}
+
+	vfree(buf);
+
+	result = iotrace_set_clock_source(iotrace_get_context(), source);
+	if (result)
+		return result;
+
+	*ppos = len;
+	return len;
+}
+
+static ssize_t filter_ops_read(struct file *file, char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	char buf[8];
+	int pos = 0;
+	uint32_t ops = iotrace_get_filter_ops(iotrace_get_context());
+
+	if (*ppos > 0)
+		return 0;
+
+	if (ops & IOTRACE_FILTER_OP_RD)
+		buf[pos++] = 'r';
+	if (ops & IOTRACE_FILTER_OP_WR)
+		buf[pos++] = 'w';
+	if (ops & IOTRACE_FILTER_OP_DISCARD)
+		buf[pos++] = 'd';
+	buf[pos++] = '\n';
+	buf[pos] = '\0';
+
+	if (copy_to_user(ubuf, buf, pos + 1))
+		return -EFAULT;
+
+	*ppos = pos + 1;
+	return pos + 1;
+}
+
+static ssize_t filter_ops_write(struct file *file, const char __user *ubuf,
+				size_t count, loff_t *ppos)
+{
+	char *buf;
+	ssize_t len;
+	uint32_t ops = 0;
+	int result;
+	size_t i;
+
+	if (*ppos > 0)
+		return -EFAULT;
+
+	len = filter_write_copy(ubuf, count, &buf);
+	if (len < 0)
+		return len;
+
+	for (i = 0; i < len; i++) {
+		switch (buf[i]) {
+		case 'r':
+			ops |= IOTRACE_FILTER_OP_RD;
+			break;
+		case 'w':
+			ops |= IOTRACE_FILTER_OP_WR;
+			break;
+		case 'd':
+			ops |= IOTRACE_FILTER_OP_DISCARD;
+			break;
+		default:
+			vfree(buf);
+			return -EINVAL;
+		}
+	}
+
+	vfree(buf);
+
+	result = iotrace_set_filter_ops(iotrace_get_context(), ops);
+	if (result)
+		return result;
+
+	*ppos = len;
+	return len;
+}
+
+static ssize_t filter_io_class_read(struct file *file, char __user *ubuf,
+				    size_t count, loff_t *ppos)
+{
+	char buf[filter_file_max_count];
+	int pos = 0;
+	unsigned i;
+	uint64_t map = iotrace_get_filter_io_class(iotrace_get_context());
+
+	if (*ppos > 0)
+		return 0;
+
+	if (map == UINT64_MAX) {
+		pos = snprintf(buf, sizeof(buf), "all\n");
+	} else {
+		for (i = 0; i < DSS_MAX; i++) {
+			if (!(map & (1ULL << i)))
+				continue;
+			pos += snprintf(buf + pos, sizeof(buf) - pos,
+					pos ? ",%u" : "%u", i);
+			if (pos >= sizeof(buf))
+				return -ENOSPC;
+		}
+		pos += snprintf(buf + pos, sizeof(buf) - pos, "\n");
+	}
+
+	if (pos < 0 || pos >= sizeof(buf))
+		return -ENOSPC;
+
+	if (copy_to_user(ubuf, buf, pos + 1))
+		return -EFAULT;
+
+	*ppos = pos + 1;
+	return pos + 1;
+}
+
+static ssize_t filter_io_class_write(struct file *file,
+				     const char __user *ubuf, size_t count,
+				     loff_t *ppos)
+{
+	char *buf, *tok, *next;
+	ssize_t len;
+	uint64_t map = 0;
+	unsigned io_class;
+	int result;
+
+	if (*ppos > 0)
+		return -EFAULT;
+
+	len = filter_write_copy(ubuf, count, &buf);
+	if (len < 0)
+		return len;
+
+	if (!strcmp(buf, "all")) {
+		map = UINT64_MAX;
+	} else {
+		next = buf;
+		while ((tok = strsep(&next, ","))) {
+			result = kstrtouint(tok, 10, &io_class);
+			if (result || io_class >= DSS_MAX) {
+				vfree(buf);
+				return result ? result : -EINVAL;
+			}
+			map |= 1ULL << io_class;
+		}
+	}
+
+	vfree(buf);
+
+	result = iotrace_set_filter_io_class(iotrace_get_context(), map);
+	if (result)
+		return result;
+
+	*ppos = len;
+	return len;
+}
+
+static ssize_t filter_lba_read(struct file *file, char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	char buf[64];
+	int pos;
+	uint64_t start, end;
+
+	if (*ppos > 0)
+		return 0;
+
+	iotrace_get_filter_lba(iotrace_get_context(), &start, &end);
+
+	pos = snprintf(buf, sizeof(buf), "%llu-%llu\n", start, end);
+	if (pos < 0 || pos >= sizeof(buf))
+		return pos < 0 ? pos : -ENOSPC;
+
+	if (copy_to_user(ubuf, buf, pos + 1))
+		return -EFAULT;
+
+	*ppos = pos + 1;
+	return pos + 1;
+}
+
+static ssize_t filter_lba_write(struct file *file, const char __user *ubuf,
+				size_t count, loff_t *ppos)
+{
+	char *buf, *sep;
+	ssize_t len;
+	unsigned long long start, end;
+	int result;
+
+	if (*ppos > 0)
+		return -EFAULT;
+
+	len = filter_write_copy(ubuf, count, &buf);
+	if (len < 0)
+		return len;
+
+	sep = strchr(buf, '-');
+	if (!sep) {
+		vfree(buf);
+		return -EINVAL;
+	}
+	*sep = '\0';
+
+	result = kstrtou64(buf, 10, &start);
+	if (!result)
+		result = kstrtou64(sep + 1, 10, &end);
+
+	vfree(buf);
+
+	if (result)
+		return result;
+
+	result = iotrace_set_filter_lba(iotrace_get_context(), start, end);
+	if (result)
+		return result;
+
+	*ppos = len;
+	return len;
+}
+
 /* device management files ops */
 static struct file_operations add_dev_ops = { .owner = THIS_MODULE,
 					      .write = add_dev_write };
@@ -450,6 +1009,44 @@ static struct file_operations size_ops = {
 	.write = size_write,
 	.read = size_read,
 };
+static struct file_operations watermark_ops = {
+	.owner = THIS_MODULE,
+	.write = watermark_write,
+	.read = watermark_read,
+};
+static struct file_operations filter_ops_ops = {
+	.owner = THIS_MODULE,
+	.write = filter_ops_write,
+	.read = filter_ops_read,
+};
+static struct file_operations filter_io_class_ops = {
+	.owner = THIS_MODULE,
+	.write = filter_io_class_write,
+	.read = filter_io_class_read,
+};
+static struct file_operations filter_lba_ops = {
+	.owner = THIS_MODULE,
+	.write = filter_lba_write,
+	.read = filter_lba_read,
+};
+static struct file_operations sampling_ops = {
+	.owner = THIS_MODULE,
+	.write = sampling_write,
+	.read = sampling_read,
+};
+static struct file_operations clock_ops = {
+	.owner = THIS_MODULE,
+	.write = clock_write,
+	.read = clock_read,
+};
+static struct file_operations drops_ops = {
+	.owner = THIS_MODULE,
+	.read = drops_read,
+};
+static struct file_operations selftest_ops = {
+	.owner = THIS_MODULE,
+	.read = selftest_read,
+};
 
 /**
  * @brief Initialize iotrace directory in /proc
@@ -473,6 +1070,20 @@ static int iotrace_procfs_mngt_init(void)
 		{ .name = IOTRACE_PROCFS_VERSION_FILE_NAME,
 		  .ops = &get_version_ops },
 		{ .name = IOTRACE_PROCFS_SIZE_FILE_NAME, .ops = &size_ops },
+		{ .name = IOTRACE_PROCFS_WATERMARK_FILE_NAME,
+		  .ops = &watermark_ops },
+		{ .name = IOTRACE_PROCFS_FILTER_OPS_FILE_NAME,
+		  .ops = &filter_ops_ops },
+		{ .name = IOTRACE_PROCFS_FILTER_IO_CLASS_FILE_NAME,
+		  .ops = &filter_io_class_ops },
+		{ .name = IOTRACE_PROCFS_FILTER_LBA_FILE_NAME,
+		  .ops = &filter_lba_ops },
+		{ .name = IOTRACE_PROCFS_SAMPLING_FILE_NAME,
+		  .ops = &sampling_ops },
+		{ .name = IOTRACE_PROCFS_CLOCK_FILE_NAME, .ops = &clock_ops },
+		{ .name = IOTRACE_PROCFS_DROPS_FILE_NAME, .ops = &drops_ops },
+		{ .name = IOTRACE_PROCFS_SELFTEST_FILE_NAME,
+		  .ops = &selftest_ops },
 	};
 	size_t num_entries = sizeof(entries) / sizeof(entries[0]);
 
@@ -502,11 +1113,36 @@ static int iotrace_procfs_mngt_init(void)
 	return 0;
 }
 
+/**
+ * @brief Helper structure passing ring parameters to the pinned allocation
+ */
+struct iotrace_ring_alloc_data {
+	/** Allocated ring buffer */
+	void *buffer;
+	/** Requested ring size */
+	uint64_t size;
+};
+
+static long _iotrace_ring_alloc_fn(void *info)
+{
+	struct iotrace_ring_alloc_data *data = info;
+
+	data->buffer = vmalloc_user(data->size);
+	return data->buffer ? 0 : -ENOMEM;
+}
+
+/* Overflow spill area is twice the ring - large enough to absorb a burst
+ * lasting several consumer scheduling latencies, cold enough not to matter
+ * when the ring keeps up */
+#define IOTRACE_SPILL_SIZE_MULT 2
+
 /* Allocate buffer for traces */
 int iotrace_procfs_trace_file_alloc(struct iotrace_proc_file *proc_file,
-				    uint64_t size)
+				    uint64_t size, unsigned cpu)
 {
+	struct iotrace_ring_alloc_data data = {};
 	void *buffer;
+	void *spill;
 
 	if (size < OCTF_TRACE_HDR_SIZE)
 		return -ENOSPC;
@@ -514,17 +1150,46 @@ int iotrace_procfs_trace_file_alloc(struct iotrace_proc_file *proc_file,
 	/* make consumer_hdr and trace ring buffer sizes add up to requested total */
 	size -= OCTF_TRACE_HDR_SIZE;
 
-	if (proc_file->trace_ring && proc_file->trace_ring_size == size)
+	if (proc_file->trace_ring && proc_file->trace_ring_size == size) {
+		/* fresh capture starts with an empty spill */
+		proc_file->spill_head = 0;
+		proc_file->spill_tail = 0;
 		return 0;
+	}
+
+	/* Spill is written only from the owning CPU on ring overflow and
+	 * read back on the same CPU, so plain vmalloc (first-touch node
+	 * placement does not apply - pages are faulted at alloc time) is
+	 * good enough for this cold path */
+	spill = vmalloc(size * IOTRACE_SPILL_SIZE_MULT);
+	if (!spill)
+		return -ENOMEM;
 
-	buffer = vmalloc_user(size);
-	if (!buffer)
+	/* Allocate the ring from a worker pinned to its CPU so the pages
+	 * land on the CPU's home NUMA node - both the producer (bio probe
+	 * on that CPU) and the node-affine consumer then access the ring
+	 * locally */
+	data.size = size;
+	if (cpu_online(cpu))
+		work_on_cpu(cpu, _iotrace_ring_alloc_fn, &data);
+	else
+		_iotrace_ring_alloc_fn(&data);
+
+	buffer = data.buffer;
+	if (!buffer) {
+		vfree(spill);
 		return -ENOMEM;
+	}
 
 	vfree(proc_file->trace_ring);
+	vfree(proc_file->spill);
 
 	proc_file->trace_ring = buffer;
 	proc_file->trace_ring_size = size;
+	proc_file->spill = spill;
+	proc_file->spill_size = size * IOTRACE_SPILL_SIZE_MULT;
+	proc_file->spill_head = 0;
+	proc_file->spill_tail = 0;
 
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2, 6, 32)
 	proc_set_size(proc_file->trace_ring_entry, size);
@@ -568,6 +1233,8 @@ static int iotrace_procfs_trace_file_init(struct iotrace_proc_file *proc_file,
 	/* Initialize wait_queue */
 	init_waitqueue_head(&(proc_file->poll_wait_queue));
 
+	spin_lock_init(&proc_file->spill_lock);
+
 	/* Allocate consumer_hdr buffer */
 	proc_file->consumer_hdr = vmalloc_user(sizeof(octf_trace_hdr_t));
 	if (!proc_file->consumer_hdr)
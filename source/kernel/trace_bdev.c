@@ -19,112 +19,200 @@ struct iotrace_bdev_data {
 	/** iotrace traced devices info */
 	struct iotrace_bdev *trace_bdev;
 	union {
-		/** block device to be added */
-		struct block_device *bdev;
+		struct {
+			/** block devices to be added */
+			struct block_device **bdevs;
+			/** number of devices to be added */
+			unsigned num;
+		};
 		/** index at which to delete a device */
 		unsigned idx;
 	};
 };
 
 /**
- * @brief Add block device pointer to per-cpu @trace_bdev array
+ * @brief Insert request queue pointer into per-cpu lookup hash
+ *
+ * @usage Caller runs pinned to @cpu (on_each_cpu context)
+ *
+ * @param trace_bdev iotrace device list
+ * @param cpu running CPU
+ * @param q request queue of added device
+ */
+static void iotrace_bdev_lookup_insert(struct iotrace_bdev *trace_bdev,
+				       unsigned cpu, struct request_queue *q)
+{
+	struct request_queue **lookup = per_cpu_ptr(trace_bdev->lookup, cpu);
+	unsigned slot = hash_ptr(q, IOTRACE_BDEV_HASH_BITS);
+
+	while (lookup[slot])
+		slot = (slot + 1) & (IOTRACE_BDEV_HASH_SIZE - 1);
+
+	lookup[slot] = q;
+}
+
+/**
+ * @brief Rebuild per-cpu lookup hash from the device array
+ *
+ * Open addressing does not allow plain slot clearing on removal, so
+ * the (tiny) table is rebuilt instead.
+ *
+ * @usage Caller runs pinned to @cpu (on_each_cpu context)
+ *
+ * @param trace_bdev iotrace device list
+ * @param cpu running CPU
+ * @param num number of valid entries in the device array
+ */
+static void iotrace_bdev_lookup_rebuild(struct iotrace_bdev *trace_bdev,
+					unsigned cpu, unsigned num)
+{
+	struct request_queue **lookup = per_cpu_ptr(trace_bdev->lookup, cpu);
+	struct block_device **bdev_list = per_cpu_ptr(trace_bdev->list, cpu);
+	unsigned i;
+
+	memset(lookup, 0,
+	       sizeof(*lookup) * IOTRACE_BDEV_HASH_SIZE);
+
+	for (i = 0; i < num; i++)
+		iotrace_bdev_lookup_insert(trace_bdev, cpu,
+					   bdev_list[i]->bd_queue);
+}
+
+/**
+ * @brief Add block device pointers to per-cpu @trace_bdev array
+ *
+ * All devices of the batch are added in this one callback, so attaching
+ * many devices costs a single cross-CPU sweep instead of one per device.
  *
  * @usage This function is designed to be called using on_each_cpu macro,
  *	  pinned to fixed CPU in order to ensure that trace_bdev->list is not
  *	  modified concurrently. Also management lock should be held by
  *	  the caller to avoid re-entrance in management path.
  *
- * @param info Input data structure (iotrace device list and bdev)
+ * @param info Input data structure (iotrace device list and bdevs)
  */
 void static iotrace_bdev_add_oncpu(void *info)
 {
 	struct iotrace_bdev_data *data = info;
 	struct iotrace_bdev *trace_bdev = data->trace_bdev;
 	unsigned cpu = smp_processor_id();
-	struct gendisk *gd = data->bdev->bd_disk;
 	struct iotrace_context *iotrace = iotrace_get_context();
-	uint64_t bdev_size = 0;
+	unsigned i;
+
+	BUG_ON(trace_bdev->num + data->num > SATRACE_MAX_DEVICES);
+
+	for (i = 0; i < data->num; i++) {
+		struct block_device *bdev = data->bdevs[i];
+		struct gendisk *gd = bdev->bd_disk;
+		uint64_t bdev_size;
+
+		bdev_size = (bdev->bd_contains == bdev) ?
+				    get_capacity(bdev->bd_disk) :
+				    bdev->bd_part->nr_sects;
 
-	bdev_size = (data->bdev->bd_contains == data->bdev) ?
-			    get_capacity(data->bdev->bd_disk) :
-			    data->bdev->bd_part->nr_sects;
+		per_cpu_ptr(trace_bdev->list, cpu)[trace_bdev->num + i] = bdev;
 
-	BUG_ON(trace_bdev->num >= SATRACE_MAX_DEVICES);
-	per_cpu_ptr(trace_bdev->list, cpu)[trace_bdev->num] = data->bdev;
+		iotrace_bdev_lookup_insert(trace_bdev, cpu, bdev->bd_queue);
 
-	iotrace_trace_desc(iotrace, cpu, disk_devt(gd), gd->disk_name, bdev_size);
+		iotrace_trace_desc(iotrace, cpu, disk_devt(gd), gd->disk_name,
+				   bdev_size);
+	}
 }
 
 /**
- * @brief Add device to trace list
+ * @brief Add devices to trace list
  *
  * @param trace_bdev iotrace block device list
- * @param path device path
+ * @param paths newline separated device paths (single path works too)
  *
- * @retval 0 device added successfully
- * @retval non-zero Error code
+ * @retval 0 all devices added successfully
+ * @retval non-zero Error code (no device of the batch is added)
  */
-int iotrace_bdev_add(struct iotrace_bdev *trace_bdev, char *path)
+int iotrace_bdev_add(struct iotrace_bdev *trace_bdev, char *paths)
 {
-	struct block_device *bdev;
+	struct block_device *bdevs[SATRACE_MAX_DEVICES];
 	struct iotrace_bdev_data data = { .trace_bdev = trace_bdev };
 	struct block_device **bdev_list;
+	struct block_device *bdev;
+	char *path, *next = paths;
+	unsigned num = 0;
 	int result;
 	unsigned i;
 
-	if (strnlen(path, PATH_MAX) >= PATH_MAX) {
-		printk(KERN_ERR "Path too long\n");
-		result = -EINVAL;
-		goto exit;
-	}
-
 	mutex_lock(&trace_bdev->lock);
 
-	if (trace_bdev->num == SATRACE_MAX_DEVICES) {
-		result = -ENOSPC;
-		goto unlock;
-	}
-
-	bdev = blkdev_get_by_path(path, FMODE_READ, trace_bdev);
-	if (IS_ERR(bdev)) {
-		result = (int)PTR_ERR(bdev);
-		printk(KERN_ERR "Error looking up block device: %d\n", result);
-		goto unlock;
-	}
-
 	/**
 	 * Get per-cpu variables. CPU can potentially change during execution
 	 * of this function, but it is ok - all CPUs should have identical copies
 	 * at this point */
 	bdev_list = per_cpu_ptr(trace_bdev->list, smp_processor_id());
 
-	/* Check if this queue is traced already */
-	for (i = 0; i < trace_bdev->num; i++) {
-		if (bdev_list[i]->bd_queue == bdev->bd_queue) {
-			printk(KERN_ERR "Device already traced\n");
-			result = -EPERM;
+	while ((path = strsep(&next, "\n"))) {
+		if (!*path)
+			continue;
+
+		if (strnlen(path, PATH_MAX) >= PATH_MAX) {
+			printk(KERN_ERR "Path too long\n");
+			result = -EINVAL;
+			goto put;
+		}
+
+		if (trace_bdev->num + num == SATRACE_MAX_DEVICES) {
+			result = -ENOSPC;
 			goto put;
 		}
+
+		bdev = blkdev_get_by_path(path, FMODE_READ, trace_bdev);
+		if (IS_ERR(bdev)) {
+			result = (int)PTR_ERR(bdev);
+			printk(KERN_ERR "Error looking up block device: %d\n",
+			       result);
+			goto put;
+		}
+		bdevs[num++] = bdev;
+
+		/* Check if this queue is traced already */
+		for (i = 0; i < trace_bdev->num; i++) {
+			if (bdev_list[i]->bd_queue == bdev->bd_queue) {
+				printk(KERN_ERR "Device already traced\n");
+				result = -EPERM;
+				goto put;
+			}
+		}
+		/* ... also within this batch */
+		for (i = 0; i < num - 1; i++) {
+			if (bdevs[i]->bd_queue == bdev->bd_queue) {
+				printk(KERN_ERR "Device already traced\n");
+				result = -EPERM;
+				goto put;
+			}
+		}
+	}
+
+	if (!num) {
+		result = -EINVAL;
+		goto unlock;
 	}
 
 	/**
-	 * Add bdev to per-cpu array, actually running code on each CPU in order
-	 * to synchronize with I/O
+	 * Add bdevs to per-cpu array, actually running code on each CPU in
+	 * order to synchronize with I/O - one sweep for the whole batch
 	 */
-	data.bdev = bdev;
+	data.bdevs = bdevs;
+	data.num = num;
 	on_each_cpu(iotrace_bdev_add_oncpu, &data, true);
 
-	trace_bdev->num++;
+	trace_bdev->num += num;
 
 	mutex_unlock(&trace_bdev->lock);
 
 	return 0;
 
 put:
-	blkdev_put(bdev, FMODE_READ);
+	for (i = 0; i < num; i++)
+		blkdev_put(bdevs[i], FMODE_READ);
 unlock:
 	mutex_unlock(&trace_bdev->lock);
-exit:
 	return result;
 }
 
@@ -150,6 +238,8 @@ void static iotrace_bdev_remove_oncpu(void *info)
 	BUG_ON(trace_bdev->num == 0);
 	bdev_list[data->idx] = bdev_list[trace_bdev->num - 1];
 	bdev_list[trace_bdev->num - 1] = NULL;
+
+	iotrace_bdev_lookup_rebuild(trace_bdev, cpu, trace_bdev->num - 1);
 }
 
 /**
@@ -201,39 +291,51 @@ exit:
 }
 
 /**
- * @brief remove device from trace list
+ * @brief remove devices from trace list
+ *
+ * Detach is not latency sensitive, so the batch is processed one device
+ * at a time; the win of a list is a single management write.
  *
  * @param trace_bdev iotrace block device list
- * @param path device path
+ * @param paths newline separated device paths (single path works too)
  *
- * @retval 0 device added successfully
- * @retval non-zero error code
+ * @retval 0 devices removed successfully
+ * @retval non-zero error code (removal stops at the failing device)
  */
-int iotrace_bdev_remove(struct iotrace_bdev *trace_bdev, char *path)
+int iotrace_bdev_remove(struct iotrace_bdev *trace_bdev, char *paths)
 {
 	struct block_device *bdev;
-	int result;
+	char *path, *next = paths;
+	int result = -EINVAL;
 
-	if (strnlen(path, PATH_MAX) >= PATH_MAX) {
-		printk(KERN_ERR "Path too long\n");
-		result = -EINVAL;
-		goto error;
-	}
+	while ((path = strsep(&next, "\n"))) {
+		if (!*path)
+			continue;
 
-	bdev = lookup_bdev(path);
-	if (IS_ERR(bdev)) {
-		result = PTR_ERR(bdev);
-		goto error;
-	}
+		if (strnlen(path, PATH_MAX) >= PATH_MAX) {
+			printk(KERN_ERR "Path too long\n");
+			result = -EINVAL;
+			break;
+		}
 
-	mutex_lock(&trace_bdev->lock);
+		bdev = lookup_bdev(path);
+		if (IS_ERR(bdev)) {
+			result = PTR_ERR(bdev);
+			break;
+		}
 
-	result = iotrace_bdev_remove_locked(trace_bdev, bdev);
+		mutex_lock(&trace_bdev->lock);
 
-	mutex_unlock(&trace_bdev->lock);
+		result = iotrace_bdev_remove_locked(trace_bdev, bdev);
+
+		mutex_unlock(&trace_bdev->lock);
+
+		bdput(bdev);
+
+		if (result)
+			break;
+	}
 
-	bdput(bdev);
-error:
 	return result;
 }
 
@@ -308,6 +410,14 @@ int iotrace_bdev_init(struct iotrace_bdev *trace_bdev)
 	if (!trace_bdev->list)
 		goto error;
 
+	trace_bdev->lookup = __alloc_percpu(
+		sizeof(struct request_queue *) * IOTRACE_BDEV_HASH_SIZE, 128);
+	if (!trace_bdev->lookup) {
+		free_percpu(trace_bdev->list);
+		trace_bdev->list = NULL;
+		goto error;
+	}
+
 	mutex_init(&trace_bdev->lock);
 
 	return 0;
@@ -323,5 +433,6 @@ error:
  */
 void iotrace_bdev_deinit(struct iotrace_bdev *trace_bdev)
 {
+	free_percpu(trace_bdev->lookup);
 	free_percpu(trace_bdev->list);
 }
@@ -0,0 +1,55 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "Crc32c.h"
+
+namespace octf {
+
+/** Reflected CRC32C polynomial */
+#define CRC32C_POLY 0x82F63B78U
+
+namespace {
+
+/**
+ * @brief Lazily built byte lookup table
+ */
+struct Crc32cTable {
+    uint32_t entry[256];
+
+    Crc32cTable() {
+        for (uint32_t byte = 0; byte < 256; byte++) {
+            uint32_t crc = byte;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+            }
+            entry[byte] = crc;
+        }
+    }
+};
+
+}  // namespace
+
+uint32_t crc32cSoftware(const void *data, size_t size) {
+    static const Crc32cTable table;
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint32_t crc = 0xFFFFFFFFU;
+
+    while (size--) {
+        crc = table.entry[(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xFFFFFFFFU;
+}
+
+Crc32cFn getCrc32c() {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return crc32cHardware;
+    }
+#endif
+    return crc32cSoftware;
+}
+
+}  // namespace octf
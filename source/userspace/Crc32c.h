@@ -0,0 +1,43 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_CRC32C_H
+#define SOURCE_USERSPACE_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace octf {
+
+/**
+ * @brief CRC32C (Castagnoli) over one buffer, finalized
+ */
+typedef uint32_t (*Crc32cFn)(const void *data, size_t size);
+
+/**
+ * @brief Portable table-driven CRC32C
+ */
+uint32_t crc32cSoftware(const void *data, size_t size);
+
+/**
+ * @brief SSE4.2 hardware CRC32C, 8 bytes per instruction
+ *
+ * Built in its own translation unit with -msse4.2; falls through to
+ * the software implementation when the target does not provide SSE4.2
+ * at compile time. Callers go through getCrc32c() - never call this
+ * without a runtime SSE4.2 check.
+ */
+uint32_t crc32cHardware(const void *data, size_t size);
+
+/**
+ * @brief Picks the fastest CRC32C implementation for this machine
+ *
+ * Resolve once and cache the pointer.
+ */
+Crc32cFn getCrc32c();
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_CRC32C_H
@@ -0,0 +1,54 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * SSE4.2 CRC32C. This translation unit is built with -msse4.2; nothing
+ * here may be called without a runtime SSE4.2 check - that is what
+ * getCrc32c() is for.
+ */
+
+#include "Crc32c.h"
+
+#if defined(__SSE4_2__)
+
+#include <nmmintrin.h>
+#include <cstring>
+
+namespace octf {
+
+uint32_t crc32cHardware(const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint64_t crc = 0xFFFFFFFFU;
+
+    while (size >= sizeof(uint64_t)) {
+        uint64_t chunk;
+        std::memcpy(&chunk, bytes, sizeof(chunk));
+        crc = _mm_crc32_u64(crc, chunk);
+        bytes += sizeof(chunk);
+        size -= sizeof(chunk);
+    }
+
+    uint32_t tail = static_cast<uint32_t>(crc);
+    while (size--) {
+        tail = _mm_crc32_u8(tail, *bytes++);
+    }
+
+    return tail ^ 0xFFFFFFFFU;
+}
+
+}  // namespace octf
+
+#else
+
+namespace octf {
+
+uint32_t crc32cHardware(const void *data, size_t size) {
+    // Toolchain without SSE4.2 - keep the symbol, fall through
+    return crc32cSoftware(data, size);
+}
+
+}  // namespace octf
+
+#endif
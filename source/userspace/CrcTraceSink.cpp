@@ -0,0 +1,32 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "CrcTraceSink.h"
+
+namespace octf {
+
+CrcTraceSink::CrcTraceSink(std::shared_ptr<ITraceSink> sink)
+        : m_sink(sink)
+        , m_crc(getCrc32c()) {}
+
+void CrcTraceSink::write(const void *data, size_t size) {
+    if (!size) {
+        return;
+    }
+
+    CrcFrameHeader header;
+    header.magic = CRC_FRAME_MAGIC;
+    header.length = size;
+    header.crc = m_crc(data, size);
+
+    m_sink->write(&header, sizeof(header));
+    m_sink->write(data, size);
+}
+
+void CrcTraceSink::flush() {
+    m_sink->flush();
+}
+
+}  // namespace octf
@@ -0,0 +1,66 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_CRCTRACESINK_H
+#define SOURCE_USERSPACE_CRCTRACESINK_H
+
+#include <memory>
+#include "Crc32c.h"
+#include "TraceSink.h"
+
+namespace octf {
+
+/**
+ * @brief Header of one CRC frame in an integrity-framed trace stream
+ *
+ * Each write becomes one frame, so frames stay independently
+ * verifiable and a reader can resynchronize on the magic past a
+ * damaged or truncated frame.
+ */
+struct CrcFrameHeader {
+    /** Frame marker, CRC_FRAME_MAGIC */
+    uint32_t magic;
+
+    /** Size of the payload following this header */
+    uint32_t length;
+
+    /** CRC32C of the payload */
+    uint32_t crc;
+} __attribute__((packed));
+
+/**
+ * @brief Trace sink stage framing the stream with CRC32C checksums
+ *
+ * Outermost stage before the file or the wire - it protects the bytes
+ * as stored, compressed or not. Silent truncation and bit rot during
+ * shipping become detectable, and since frames verify independently a
+ * damaged transfer loses frames, not the capture. SSE4.2 hardware CRC
+ * (picked at runtime) keeps the cost invisible next to compression.
+ */
+class CrcTraceSink : public ITraceSink {
+public:
+    /** Frame marker value ("TCRC") */
+    static const uint32_t CRC_FRAME_MAGIC = 0x43524354;
+
+    /**
+     * @param sink Sink receiving the framed stream
+     */
+    CrcTraceSink(std::shared_ptr<ITraceSink> sink);
+    virtual ~CrcTraceSink() = default;
+
+    void write(const void *data, size_t size) override;
+
+    void flush() override;
+
+private:
+    std::shared_ptr<ITraceSink> m_sink;
+
+    /** CRC implementation, resolved once per machine */
+    Crc32cFn m_crc;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_CRCTRACESINK_H
@@ -0,0 +1,43 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "FileTraceSink.h"
+#include <octf/utils/Exception.h>
+
+namespace octf {
+
+FileTraceSink::FileTraceSink(const std::string &path)
+        : m_path(path)
+        , m_file()
+        , m_written(0) {
+    m_file.open(path, std::ios_base::out | std::ios_base::binary |
+                              std::ios_base::trunc);
+    if (m_file.fail()) {
+        throw Exception("Failed to open trace output file: " + path);
+    }
+}
+
+FileTraceSink::~FileTraceSink() {
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+}
+
+void FileTraceSink::write(const void *data, size_t size) {
+    m_file.write(static_cast<const char *>(data), size);
+    if (m_file.fail()) {
+        throw Exception("Failed to write trace output file: " + m_path);
+    }
+    m_written += size;
+}
+
+void FileTraceSink::flush() {
+    m_file.flush();
+    if (m_file.fail()) {
+        throw Exception("Failed to flush trace output file: " + m_path);
+    }
+}
+
+}  // namespace octf
@@ -0,0 +1,52 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_FILETRACESINK_H
+#define SOURCE_USERSPACE_FILETRACESINK_H
+
+#include <fstream>
+#include <string>
+#include "TraceSink.h"
+
+namespace octf {
+
+/**
+ * @brief Trace sink appending drained batches to a file
+ */
+class FileTraceSink : public ITraceSink {
+public:
+    /**
+     * @param path Output file path, created or truncated
+     */
+    FileTraceSink(const std::string &path);
+    virtual ~FileTraceSink();
+
+    void write(const void *data, size_t size) override;
+
+    void flush() override;
+
+    /**
+     * @brief Gets number of bytes written so far
+     */
+    uint64_t getWrittenBytes() const {
+        return m_written;
+    }
+
+    /**
+     * @brief Gets output file path
+     */
+    const std::string &getPath() const {
+        return m_path;
+    }
+
+private:
+    std::string m_path;
+    std::ofstream m_file;
+    uint64_t m_written;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_FILETRACESINK_H
@@ -9,11 +9,25 @@
 #include <octf/proto/trace.pb.h>
 #include <octf/trace/iotrace_event.h>
 #include <octf/utils/Exception.h>
+#include <octf/utils/Log.h>
 #include <octf/utils/SignalHandler.h>
 #include <sys/types.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <cstdio>
+#include <sstream>
 #include <string>
+#include <thread>
+#include "CrcTraceSink.h"
+#include "FileTraceSink.h"
 #include "KernelTraceExecutor.h"
+#include "Lz4TraceSink.h"
+#include "ODirectFileSink.h"
+#include "TcpTraceSink.h"
+#include "TraceFormatV2.h"
+#include "TraceIndex.h"
+#include "TraceStatistics.h"
 
 namespace octf {
 
@@ -21,6 +35,209 @@ InterfaceKernelTraceCreatingImpl::InterfaceKernelTraceCreatingImpl(
         const NodePath &nodePath)
         : m_nodePath(nodePath) {}
 
+uint64_t InterfaceKernelTraceCreatingImpl::runPipelineCapture(
+        KernelTraceExecutor &executor,
+        TraceDrainPipeline &pipeline,
+        uint32_t maxDuration,
+        const TraceProgressReporter::Config &progress) {
+    if (!executor.startTrace()) {
+        throw Exception("Cannot start kernel tracing");
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    pipeline.start();
+
+    // Make the running capture observable - the reporter only reads
+    // the pipeline counters, the drain threads never notice it
+    TraceProgressReporter reporter(
+            pipeline,
+            [&executor] {
+                std::map<uint32_t, uint64_t> perCpu;
+                return executor.getDroppedEvents(perCpu);
+            },
+            progress);
+    reporter.start();
+
+    SignalHandler::get().registerSignal(SIGINT);
+    SignalHandler::get().registerSignal(SIGTERM);
+    SignalHandler::get().registerSignal(SIGUSR1);
+
+    // Cap the capture length like the storing mode does
+    std::atomic<bool> interrupted(false);
+    std::thread timer([maxDuration, &interrupted] {
+        for (uint32_t i = 0; i < maxDuration; i++) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (interrupted) {
+                return;
+            }
+        }
+        raise(SIGUSR1);
+    });
+
+    SignalHandler::get().wait();
+    interrupted = true;
+
+    // Stop producing first, then drain ring remainders
+    executor.stopTrace();
+    reporter.stop();
+    pipeline.stop();
+    timer.join();
+
+    return std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::steady_clock::now() - begin)
+            .count();
+}
+
+void InterfaceKernelTraceCreatingImpl::statsOnlyTracing(
+        const std::vector<std::string> &devices,
+        uint32_t circBufferSize,
+        const KernelTraceFilters &filters,
+        uint32_t maxDuration,
+        const TraceProgressReporter::Config &progress) {
+    KernelTraceExecutor kernelExecutor(devices, circBufferSize, filters);
+    TraceStatisticsCollector collector(kernelExecutor.getTraceQueueCount(),
+                                       circBufferSize);
+
+    uint64_t seconds = runPipelineCapture(kernelExecutor, collector,
+                                          maxDuration, progress);
+
+    std::ostringstream summary;
+    collector.printSummary(summary, seconds);
+    log::cout << summary.str();
+    log::cout << "Events observed: " << collector.getDrainedEvents()
+              << std::endl;
+}
+
+void InterfaceKernelTraceCreatingImpl::remoteTracing(
+        const std::vector<std::string> &devices,
+        uint32_t circBufferSize,
+        const KernelTraceFilters &filters,
+        uint32_t maxDuration,
+        const std::string &target,
+        const TraceProgressReporter::Config &progress) {
+    size_t colon = target.rfind(':');
+    if (colon == std::string::npos || !colon ||
+        colon + 1 == target.length()) {
+        throw Exception("Remote target has to be given as <host>:<port>");
+    }
+
+    std::string host = target.substr(0, colon);
+    uint16_t port;
+    try {
+        unsigned long value = std::stoul(target.substr(colon + 1));
+        if (!value || value > UINT16_MAX) {
+            throw std::out_of_range("port");
+        }
+        port = value;
+    } catch (const std::exception &) {
+        throw Exception("Invalid remote target port in " + target);
+    }
+
+    KernelTraceExecutor kernelExecutor(devices, circBufferSize, filters);
+    auto tcp = std::make_shared<TcpTraceSink>(host, port);
+
+    // Integrity-frame the wire bytes - truncated or damaged transfers
+    // lose frames, not the capture
+    std::shared_ptr<ITraceSink> crc = std::make_shared<CrcTraceSink>(tcp);
+
+    // Compress before the wire - the trace competes with production
+    // traffic for the NIC
+    std::shared_ptr<ITraceSink> stack = std::make_shared<Lz4TraceSink>(crc);
+    auto v2 = std::make_shared<V2EncodingSink>(stack);
+
+    // The v2 header records which clock stamped the events plus its
+    // calibration; read it live - the module calibrates at attach,
+    // which happens before the first batch is encoded
+    v2->setClockInfoProvider([&kernelExecutor](uint8_t &source,
+                                               uint64_t &raw,
+                                               uint64_t &real) {
+        std::string name;
+        kernelExecutor.getClockInfo(name, raw, real);
+        source = (name == "sched") ? TraceFormatV2::CLOCK_SCHED
+                                   : TraceFormatV2::CLOCK_KTIME;
+    });
+
+    TraceDrainPipeline pipeline(kernelExecutor.getTraceQueueCount(),
+                                circBufferSize, v2);
+
+    runPipelineCapture(kernelExecutor, pipeline, maxDuration, progress);
+
+    log::cout << "Events streamed: " << pipeline.getDrainedEvents()
+              << ", bytes on wire: " << tcp->getSentBytes() << std::endl;
+    if (tcp->getDroppedFrames()) {
+        log::cerr << "Frames dropped under backpressure: "
+                  << tcp->getDroppedFrames() << " ("
+                  << tcp->getDroppedBytes() << " bytes)" << std::endl;
+    }
+    if (!tcp->isConnected()) {
+        log::cerr << "Collector connection was lost during the capture"
+                  << std::endl;
+    }
+}
+
+void InterfaceKernelTraceCreatingImpl::continuousTracing(
+        const std::vector<std::string> &devices,
+        uint32_t circBufferSize,
+        const KernelTraceFilters &filters,
+        uint32_t maxDuration,
+        const RotatingTraceSink::Config &rotating,
+        bool oDirect,
+        const TraceProgressReporter::Config &progress) {
+    KernelTraceExecutor kernelExecutor(devices, circBufferSize, filters);
+
+    // Every segment gets its own encoding stack so it decodes on its
+    // own - the v2 header is rewritten at the head of each file
+    RotatingTraceSink::SegmentFactory factory =
+            [&kernelExecutor, oDirect](
+                    const std::string &path) -> std::shared_ptr<ITraceSink> {
+        // O_DIRECT keeps a long-running capture from evicting the page
+        // cache of the workload it is measuring; segment close runs the
+        // sink's finalizing flush either way
+        std::shared_ptr<ITraceSink> file;
+        std::function<uint64_t()> offset;
+        if (oDirect) {
+            auto direct = std::make_shared<ODirectFileSink>(path);
+            offset = [direct] { return direct->getWrittenBytes(); };
+            file = direct;
+        } else {
+            auto buffered = std::make_shared<FileTraceSink>(path);
+            offset = [buffered] { return buffered->getWrittenBytes(); };
+            file = buffered;
+        }
+        auto v2 = std::make_shared<V2EncodingSink>(file);
+        v2->setClockInfoProvider([&kernelExecutor](uint8_t &source,
+                                                   uint64_t &raw,
+                                                   uint64_t &real) {
+            std::string name;
+            kernelExecutor.getClockInfo(name, raw, real);
+            source = (name == "sched") ? TraceFormatV2::CLOCK_SCHED
+                                       : TraceFormatV2::CLOCK_KTIME;
+        });
+
+        // The index sidecar lets a later range parse enter the segment
+        // mid-file instead of scanning it from the start
+        return std::make_shared<IndexingTraceSink>(
+                v2, path + TraceIndexWriter::SUFFIX, offset);
+    };
+
+    auto sink = std::make_shared<RotatingTraceSink>(rotating, factory);
+
+    TraceDrainPipeline pipeline(kernelExecutor.getTraceQueueCount(),
+                                circBufferSize, sink);
+
+    runPipelineCapture(kernelExecutor, pipeline, maxDuration, progress);
+
+    log::cout << "Events captured: " << pipeline.getDrainedEvents()
+              << ", segments rotated: " << sink->getRotations() << std::endl;
+
+    std::map<uint32_t, uint64_t> drops;
+    uint64_t totalDrops = kernelExecutor.getDroppedEvents(drops);
+    if (totalDrops) {
+        log::cerr << "Events lost on ring overflow: " << totalDrops
+                  << std::endl;
+    }
+}
+
 bool InterfaceKernelTraceCreatingImpl::checkIntegerParameters(
         const uint32_t value,
         const std::string &fieldName,
@@ -61,7 +278,69 @@ void InterfaceKernelTraceCreatingImpl::StartTracing(
             devices[i] = request->devicepaths(i);
         }
 
-        KernelTraceExecutor kernelExecutor(devices, circBufferSize);
+        KernelTraceFilters filters;
+        filters.ops = request->traceops();
+        filters.ioClasses = request->traceioclasses();
+        filters.lbaRange = request->tracelbarange();
+        filters.samplingRatio = request->samplingratio();
+        filters.clockSource = request->clocksource();
+
+        if (filters.samplingRatio &&
+            !checkIntegerParameters(filters.samplingRatio, "samplingratio",
+                                    descriptor)) {
+            throw Exception("Invalid sampling ratio");
+        }
+
+        TraceProgressReporter::Config progress;
+        progress.intervalSeconds = request->progressinterval();
+        progress.socketPath = request->progresssocket();
+
+        if (request->statsonly()) {
+            statsOnlyTracing(devices, circBufferSize, filters, maxDuration,
+                             progress);
+            done->Run();
+            return;
+        }
+
+        if (!request->remotetarget().empty()) {
+            remoteTracing(devices, circBufferSize, filters, maxDuration,
+                          request->remotetarget(), progress);
+            done->Run();
+            return;
+        }
+
+        if (!request->outputdir().empty()) {
+            if (!checkIntegerParameters(request->segmentsize(), "segmentsize",
+                                        descriptor)) {
+                throw Exception("Invalid segment size");
+            }
+            if (!checkIntegerParameters(request->retention(), "retention",
+                                        descriptor)) {
+                throw Exception("Invalid retention size");
+            }
+
+            RotatingTraceSink::Config rotating;
+            rotating.dir = request->outputdir();
+            rotating.segmentBytes =
+                    request->segmentsize() * 1024ULL * 1024ULL;
+            rotating.segmentSeconds = request->segmenttime();
+            rotating.retentionBytes =
+                    request->retention() * 1024ULL * 1024ULL;
+            rotating.compress = request->compresssegments();
+
+            if (!rotating.segmentBytes && !rotating.segmentSeconds) {
+                throw Exception(
+                        "Continuous capture needs a size or time "
+                        "roll trigger");
+            }
+
+            continuousTracing(devices, circBufferSize, filters, maxDuration,
+                              rotating, request->odirect(), progress);
+            done->Run();
+            return;
+        }
+
+        KernelTraceExecutor kernelExecutor(devices, circBufferSize, filters);
 
         TraceManager manager(m_nodePath, &kernelExecutor);
 
@@ -81,6 +360,29 @@ void InterfaceKernelTraceCreatingImpl::StartTracing(
 
         TracingState state = manager.getState();
         manager.fillTraceSummary(response, state);
+
+        // Surface ring overflow accounting so every trace artifact carries
+        // its own completeness information
+        std::map<uint32_t, uint64_t> drops;
+        uint64_t totalDrops = kernelExecutor.getDroppedEvents(drops);
+        if (totalDrops) {
+            log::cerr << "Events lost on ring overflow: " << totalDrops
+                      << std::endl;
+            for (const auto &entry : drops) {
+                log::cerr << "  cpu " << entry.first << ": " << entry.second
+                          << std::endl;
+            }
+            log::cerr << "Consider increasing the circular buffer size"
+                      << std::endl;
+        }
+
+        if (filters.samplingRatio > 1) {
+            // Event counts in the summary are of sampled events; consumers
+            // rescale by this factor
+            log::cout << "Trace sampled 1-in-" << filters.samplingRatio
+                      << ", scale counts accordingly" << std::endl;
+        }
+
         done->Run();
     } catch (Exception &e) {
         controller->SetFailed(e.what());
@@ -8,7 +8,13 @@
 
 #include <octf/interface/ITraceExecutor.h>
 #include <octf/node/INode.h>
+#include <string>
+#include <vector>
 #include "InterfaceKernelTraceCreating.pb.h"
+#include "KernelTraceExecutor.h"
+#include "RotatingTraceSink.h"
+#include "TraceDrainPipeline.h"
+#include "TraceProgressReporter.h"
 
 namespace octf {
 
@@ -30,6 +36,59 @@ public:
                               ::google::protobuf::Closure *done);
 
 private:
+    /**
+     * @brief Runs a stats-only capture (no trace stored)
+     *
+     * Drains the rings into streaming aggregates and prints the summary
+     * when the capture ends.
+     */
+    void statsOnlyTracing(const std::vector<std::string> &devices,
+                          uint32_t circBufferSize,
+                          const KernelTraceFilters &filters,
+                          uint32_t maxDuration,
+                          const TraceProgressReporter::Config &progress);
+
+    /**
+     * @brief Streams the capture to a remote collector (no local file)
+     *
+     * @param target Collector as <host>:<port>
+     */
+    void remoteTracing(const std::vector<std::string> &devices,
+                       uint32_t circBufferSize,
+                       const KernelTraceFilters &filters,
+                       uint32_t maxDuration,
+                       const std::string &target,
+                       const TraceProgressReporter::Config &progress);
+
+    /**
+     * @brief Captures continuously into rotating segment files
+     *
+     * Each segment is a self-contained v2 shard; finished segments are
+     * optionally compressed in the background and the oldest ones pruned
+     * against the retention budget, so the capture can run indefinitely.
+     *
+     * @param rotating Segment directory, roll triggers and retention
+     * @param oDirect Write segments through O_DIRECT, bypassing the
+     *        page cache
+     */
+    void continuousTracing(const std::vector<std::string> &devices,
+                           uint32_t circBufferSize,
+                           const KernelTraceFilters &filters,
+                           uint32_t maxDuration,
+                           const RotatingTraceSink::Config &rotating,
+                           bool oDirect,
+                           const TraceProgressReporter::Config &progress);
+
+    /**
+     * @brief Shared run loop of the pipeline based capture modes
+     *
+     * @return Capture length in seconds
+     */
+    uint64_t runPipelineCapture(KernelTraceExecutor &executor,
+                                TraceDrainPipeline &pipeline,
+                                uint32_t maxDuration,
+                                const TraceProgressReporter::Config &progress);
+
     bool checkIntegerParameters(
             const uint32_t value,
             const std::string &fieldName,
@@ -0,0 +1,59 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "InterfaceTraceReplayingImpl.h"
+#include <octf/utils/Exception.h>
+#include <octf/utils/Log.h>
+#include "TraceReplayEngine.h"
+
+namespace octf {
+
+void InterfaceTraceReplayingImpl::ReplayTrace(
+        ::google::protobuf::RpcController *controller,
+        const ::octf::proto::ReplayTraceRequest *request,
+        ::octf::proto::ReplaySummary *response,
+        ::google::protobuf::Closure *done) {
+    try {
+        ReplayConfig config;
+
+        for (int i = 0; i < request->shardpaths_size(); i++) {
+            config.shardPaths.push_back(request->shardpaths(i));
+        }
+        for (int i = 0; i < request->devicepaths_size(); i++) {
+            config.devicePaths.push_back(request->devicepaths(i));
+        }
+        config.timeScalePercent = request->timescale();
+        config.workers = request->workers();
+        config.allowWrites = request->allowwrites();
+        config.dryRun = request->dryrun();
+
+        if (config.allowWrites && !config.dryRun) {
+            log::cout << "Replaying destructively - writes and discards "
+                         "hit the targets"
+                      << std::endl;
+        }
+
+        TraceReplayEngine engine(config);
+        ReplayStatistics stats = engine.replay();
+
+        response->set_events(stats.events);
+        response->set_ios(stats.ios);
+        response->set_readbytes(stats.readBytes);
+        response->set_writtenbytes(stats.writtenBytes);
+        response->set_skipped(stats.skipped);
+        response->set_errors(stats.errors);
+        response->set_requestedus(stats.requestedUs);
+        response->set_achievedus(stats.achievedUs);
+        response->set_lagavgus(stats.lagAvgUs);
+        response->set_lagmaxus(stats.lagMaxUs);
+
+        done->Run();
+    } catch (Exception &e) {
+        controller->SetFailed(e.what());
+        done->Run();
+    }
+}
+
+}  // namespace octf
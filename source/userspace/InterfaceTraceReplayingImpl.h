@@ -0,0 +1,29 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_INTERFACETRACEREPLAYINGIMPL_H
+#define SOURCE_USERSPACE_INTERFACETRACEREPLAYINGIMPL_H
+
+#include "InterfaceTraceReplaying.pb.h"
+
+namespace octf {
+
+/**
+ * @brief Interface replaying captured traces as real I/O
+ */
+class InterfaceTraceReplayingImpl : public proto::InterfaceTraceReplaying {
+public:
+    InterfaceTraceReplayingImpl() = default;
+    virtual ~InterfaceTraceReplayingImpl() = default;
+
+    virtual void ReplayTrace(::google::protobuf::RpcController *controller,
+                             const ::octf::proto::ReplayTraceRequest *request,
+                             ::octf::proto::ReplaySummary *response,
+                             ::google::protobuf::Closure *done);
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_INTERFACETRACEREPLAYINGIMPL_H
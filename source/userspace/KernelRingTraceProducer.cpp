@@ -18,6 +18,7 @@
 #include <string>
 #include <system_error>
 #include "InterfaceKernelTraceCreatingImpl.h"
+#include "RingPoller.h"
 
 namespace octf {
 
@@ -60,7 +61,8 @@ KernelRingTraceProducer::MappedFile::~MappedFile() {
 }
 
 KernelRingTraceProducer::KernelRingTraceProducer(int cpuId)
-        : m_stopped(false)
+        : m_consumerTrace(nullptr)
+        , m_stopped(false)
         , m_cpuId(cpuId) {}
 
 KernelRingTraceProducer::~KernelRingTraceProducer() {
@@ -93,35 +95,21 @@ octf_trace_hdr_t *KernelRingTraceProducer::getConsumerHeader(void) {
 
 bool KernelRingTraceProducer::wait(
         std::chrono::time_point<std::chrono::steady_clock> &endTime) {
-    fd_set readFileDescriptors;
-    struct timeval tv;
-    int result;
-
     while (!m_stopped) {
-        if (std::chrono::steady_clock::now() >= endTime) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= endTime) {
             return false;
         }
 
-        // Poll trace file for possible reads
-        FD_ZERO(&readFileDescriptors);
-        FD_SET(m_ring->fd, &readFileDescriptors);
-
-        // Timeout - 0.5s
-        tv.tv_sec = 0;
-        tv.tv_usec = 500000;
-
-        result = select(m_ring->fd + 1, &readFileDescriptors, nullptr, nullptr,
-                        &tv);
-
-        if (result < 0) {
-            // Error
-            throw Exception("select() failed with: " + std::to_string(result));
-
-        } else if (result == 0) {
-            // Timeout - no events, poll until producer is stopped
-            continue;
+        // Park on the shared poller instead of select()-ing this ring's
+        // fd in every consumer thread. Wake up at least every 0.5s to
+        // check the stop flag, like the former select() timeout did.
+        auto deadline = now + std::chrono::milliseconds(500);
+        if (deadline > endTime) {
+            deadline = endTime;
+        }
 
-        } else if (FD_ISSET(m_ring->fd, &readFileDescriptors)) {
+        if (RingPoller::get().waitForData(m_ring->fd, deadline)) {
             // Events are ready to be read
             return true;
         }
@@ -158,13 +146,70 @@ void KernelRingTraceProducer::initRing(uint32_t memoryPoolSize) {
 
     m_ring = std::move(ring);
     m_consumer_hdr = std::move(consumer_hdr);
+
+    RingPoller::get().addRing(m_ring->fd);
+
+    // Open consumer side handle over the mapped ring for batched drain.
+    // Consumer mode only updates the consumer header, which is the sole
+    // RW mapping, so the read-only ring mapping is respected.
+    if (octf_trace_open(m_ring->buffer, m_ring->length,
+                        reinterpret_cast<octf_trace_hdr_t *>(
+                                m_consumer_hdr->buffer),
+                        octf_trace_open_mode_consumer, &m_consumerTrace)) {
+        RingPoller::get().removeRing(m_ring->fd);
+        m_ring = NULL;
+        m_consumer_hdr = NULL;
+        throw Exception("Failed to open consumer handle of trace ring");
+    }
 }
 
 void KernelRingTraceProducer::deinitRing() {
+    if (m_consumerTrace) {
+        octf_trace_close(&m_consumerTrace);
+        m_consumerTrace = nullptr;
+    }
+    if (m_ring) {
+        RingPoller::get().removeRing(m_ring->fd);
+    }
     m_ring = NULL;
     m_consumer_hdr = NULL;
 }
 
+uint32_t KernelRingTraceProducer::drainBatch(TraceEventBatch &batch) {
+    batch.count = 0;
+
+    if (!m_consumerTrace) {
+        return 0;
+    }
+
+    // Claim events in place until the ring runs dry or the batch is full.
+    // The consumer header write-back is deferred to releaseBatch(), so one
+    // wakeup handles hundreds of events with a single header round trip.
+    while (batch.count < TraceEventBatch::MAX_EVENTS) {
+        void *event;
+        uint32_t size;
+        int result = octf_trace_get_rd_buffer(
+                m_consumerTrace, &batch.handles[batch.count], &event, &size);
+        if (result) {
+            break;
+        }
+
+        batch.events[batch.count] = event;
+        batch.sizes[batch.count] = size;
+        batch.count++;
+    }
+
+    return batch.count;
+}
+
+void KernelRingTraceProducer::releaseBatch(const TraceEventBatch &batch) {
+    uint32_t i;
+
+    for (i = 0; i < batch.count; i++) {
+        octf_trace_release_rd_buffer(m_consumerTrace, batch.handles[i]);
+    }
+}
+
 int KernelRingTraceProducer::getCpuAffinity(void) {
     return m_cpuId;
 }
@@ -15,6 +15,8 @@
 #include <unistd.h>
 #include <cstdio>
 #include <fstream>
+#include <iterator>
+#include <sstream>
 #include <string>
 #include "InterfaceKernelTraceCreatingImpl.h"
 #include "KernelRingTraceProducer.h"
@@ -23,36 +25,92 @@ namespace octf {
 
 KernelTraceExecutor::KernelTraceExecutor(
         const std::vector<std::string> &devices,
-        uint32_t ringSizeMiB)
+        uint32_t ringSizeMiB,
+        const KernelTraceFilters &filters)
         : m_devices(devices) {
     if (!isKernelModuleLoaded()) {
         throw Exception("Kernel tracing module is not loaded.");
     }
 
     try {
-        writeSatraceProcfs(IOTRACE_PROCFS_SIZE_FILE_NAME,
-                           std::to_string(ringSizeMiB));
+        // Writing the size file rebuilds the rings only when the size
+        // actually changes; skipping the write for an unchanged size
+        // keeps back-to-back captures from touching the pool at all
+        if (readSatraceProcfs(IOTRACE_PROCFS_SIZE_FILE_NAME) !=
+            std::to_string(ringSizeMiB)) {
+            writeSatraceProcfs(IOTRACE_PROCFS_SIZE_FILE_NAME,
+                               std::to_string(ringSizeMiB));
+        }
     } catch (Exception &) {
         throw Exception("Failed to set ring buffer size \n");
     }
 
+    setupFilters(filters);
+
     // Check if kernel module version is compatible
     if (!checkModuleCompatibility()) {
         throw Exception("Kernel module version is incompatible.");
     }
 }
 
-bool KernelTraceExecutor::startTrace() {
+void KernelTraceExecutor::setupFilters(const KernelTraceFilters &filters) {
+    try {
+        // Always write all filter files - empty request fields reset
+        // filters possibly left over from a previous session
+        writeSatraceProcfs(IOTRACE_PROCFS_FILTER_OPS_FILE_NAME,
+                           filters.ops.empty() ? "rwd" : filters.ops);
+        writeSatraceProcfs(IOTRACE_PROCFS_FILTER_IO_CLASS_FILE_NAME,
+                           filters.ioClasses.empty() ? "all"
+                                                     : filters.ioClasses);
+        writeSatraceProcfs(IOTRACE_PROCFS_FILTER_LBA_FILE_NAME,
+                           filters.lbaRange.empty() ? "0-0"
+                                                    : filters.lbaRange);
+        uint32_t ratio = filters.samplingRatio ? filters.samplingRatio : 1;
+        writeSatraceProcfs(IOTRACE_PROCFS_SAMPLING_FILE_NAME,
+                           std::to_string(ratio));
+        writeSatraceProcfs(IOTRACE_PROCFS_CLOCK_FILE_NAME,
+                           filters.clockSource.empty() ? "ktime"
+                                                       : filters.clockSource);
+    } catch (Exception &) {
+        throw Exception("Failed to set trace filters");
+    }
+}
+
+void KernelTraceExecutor::getClockInfo(std::string &source,
+                                       uint64_t &raw,
+                                       uint64_t &real) {
+    std::istringstream line(
+            readSatraceProcfs(IOTRACE_PROCFS_CLOCK_FILE_NAME));
+
+    if (!(line >> source >> raw >> real)) {
+        throw Exception("Cannot read kernel clock calibration");
+    }
+}
+
+std::string KernelTraceExecutor::joinDevicePaths() {
+    std::string joined;
+
     for (const auto &dev : m_devices) {
-        writeSatraceProcfs(IOTRACE_PROCFS_ADD_DEVICE_FILE_NAME, dev);
+        if (!joined.empty()) {
+            joined += "\n";
+        }
+        joined += dev;
     }
+
+    return joined;
+}
+
+bool KernelTraceExecutor::startTrace() {
+    // One newline separated write attaches the whole set with a single
+    // cross-CPU sweep in the module
+    writeSatraceProcfs(IOTRACE_PROCFS_ADD_DEVICE_FILE_NAME,
+                       joinDevicePaths());
     return true;
 }
 
 bool KernelTraceExecutor::stopTrace() {
-    for (const auto &dev : m_devices) {
-        writeSatraceProcfs(IOTRACE_PROCFS_REMOVE_DEVICE_FILE_NAME, dev);
-    }
+    writeSatraceProcfs(IOTRACE_PROCFS_REMOVE_DEVICE_FILE_NAME,
+                       joinDevicePaths());
 
     SignalHandler::get().sendUserSignal();
     return true;
@@ -72,6 +130,27 @@ std::unique_ptr<ITraceConverter> KernelTraceExecutor::createTraceConverter() {
     return std::unique_ptr<TraceConverter>(new TraceConverter());
 }
 
+uint64_t KernelTraceExecutor::getDroppedEvents(
+        std::map<uint32_t, uint64_t> &perCpu) {
+    std::string path = std::string(IOTRACE_PROCFS_DIR) +
+                       "/" IOTRACE_PROCFS_DROPS_FILE_NAME;
+    std::ifstream file(path);
+    uint64_t total = 0;
+
+    perCpu.clear();
+
+    uint32_t cpu;
+    uint64_t drops;
+    while (file >> cpu >> drops) {
+        if (drops) {
+            perCpu[cpu] = drops;
+            total += drops;
+        }
+    }
+
+    return total;
+}
+
 bool KernelTraceExecutor::isKernelModuleLoaded() {
     std::string versionFilePath = std::string(IOTRACE_PROCFS_DIR) +
                                   "/" IOTRACE_PROCFS_VERSION_FILE_NAME;
@@ -115,6 +194,26 @@ bool KernelTraceExecutor::checkModuleCompatibility() {
     return true;
 }
 
+std::string KernelTraceExecutor::readSatraceProcfs(const std::string &file) {
+    std::string path = std::string{IOTRACE_PROCFS_DIR} + "/" + file;
+    std::ifstream fd(path);
+
+    if (fd.fail()) {
+        throw Exception("Failed to open file: " + file);
+    }
+
+    std::string content((std::istreambuf_iterator<char>(fd)),
+                        std::istreambuf_iterator<char>());
+
+    // Handlers NUL terminate their output
+    while (!content.empty() &&
+           (content.back() == '\0' || content.back() == '\n')) {
+        content.pop_back();
+    }
+
+    return content;
+}
+
 void KernelTraceExecutor::writeSatraceProcfs(std::string file,
                                              const std::string &text) {
     std::string path = std::string{IOTRACE_PROCFS_DIR} + "/" + file;
@@ -6,6 +6,7 @@
 #ifndef SOURCE_USERSPACE_KERNELTRACEEXECUTOR_H
 #define SOURCE_USERSPACE_KERNELTRACEEXECUTOR_H
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -15,6 +16,28 @@
 
 namespace octf {
 
+/**
+ * @brief Event filters applied by the kernel module in the bio probe
+ *
+ * Empty fields leave the corresponding filter wide open.
+ */
+struct KernelTraceFilters {
+    /** Traced operations, subset of "rwd" */
+    std::string ops;
+
+    /** Comma separated DSS io class ids */
+    std::string ioClasses;
+
+    /** Traced LBA range as "<start>-<end>" in sectors */
+    std::string lbaRange;
+
+    /** Trace one in N bios per CPU, 0/1 traces everything */
+    uint32_t samplingRatio = 1;
+
+    /** Probe timestamp source, "ktime" (default) or "sched" */
+    std::string clockSource;
+};
+
 /**
  * @brief Trace executor which allows tracing from kernel
  *
@@ -25,9 +48,13 @@ class KernelTraceExecutor : public ITraceExecutor {
 public:
     /**
      * @param devices Vector with paths of block devices to be traced
+     * @param circBufferSize Size of the internal trace buffer (in MiB)
+     * @param filters Event filters applied in the kernel probe
      */
     KernelTraceExecutor(const std::vector<std::string> &devices,
-                        uint32_t circBufferSize);
+                        uint32_t circBufferSize,
+                        const KernelTraceFilters &filters =
+                                KernelTraceFilters());
 
     virtual ~KernelTraceExecutor() = default;
 
@@ -45,6 +72,31 @@ public:
 
     std::unique_ptr<ITraceConverter> createTraceConverter() override;
 
+    /**
+     * @brief Reads per CPU dropped event counters from the kernel module
+     *
+     * Counters cover the current capture - the module resets them when
+     * the trace buffers are (re)initialized.
+     *
+     * @param[out] perCpu Drop counts of CPUs which lost events
+     *
+     * @return Total number of events dropped on ring overflow
+     */
+    uint64_t getDroppedEvents(std::map<uint32_t, uint64_t> &perCpu);
+
+    /**
+     * @brief Reads the probe clock source and its calibration
+     *
+     * The module calibrates the selected source against CLOCK_REALTIME
+     * when tracing attaches, so call this only after the capture
+     * started (the consumers opened the ring files).
+     *
+     * @param[out] source Source name as configured ("ktime"/"sched")
+     * @param[out] raw Reading of the source at attach
+     * @param[out] real CLOCK_REALTIME ns taken at the same instant
+     */
+    void getClockInfo(std::string &source, uint64_t &raw, uint64_t &real);
+
 private:
     bool isKernelModuleLoaded();
 
@@ -52,6 +104,12 @@ private:
 
     void writeSatraceProcfs(std::string file, const std::string &text);
 
+    std::string readSatraceProcfs(const std::string &file);
+
+    void setupFilters(const KernelTraceFilters &filters);
+
+    std::string joinDevicePaths();
+
     std::vector<std::string> m_devices;
 };
 
@@ -0,0 +1,85 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "Lz4TraceSink.h"
+#include <lz4.h>
+#include <octf/utils/Exception.h>
+#include <cstring>
+
+namespace octf {
+
+Lz4TraceSink::Lz4TraceSink(std::shared_ptr<ITraceSink> sink)
+        : m_sink(sink)
+        , m_compressed()
+        , m_rawBytes(0)
+        , m_compressedBytes(0) {
+    if (!m_sink) {
+        throw Exception("No sink provided for LZ4 compression stage");
+    }
+}
+
+void Lz4TraceSink::write(const void *data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    if (size > LZ4_MAX_INPUT_SIZE) {
+        throw Exception("Trace batch too large to compress");
+    }
+
+    Lz4FrameHeader header;
+    header.magic = LZ4_FRAME_MAGIC;
+    header.rawSize = size;
+
+    m_compressed.resize(LZ4_compressBound(size));
+
+    int result = LZ4_compress_default(static_cast<const char *>(data),
+                                      m_compressed.data(), size,
+                                      m_compressed.size());
+
+    const void *payload;
+    if (result > 0 && static_cast<size_t>(result) < size) {
+        header.compressedSize = result;
+        payload = m_compressed.data();
+    } else {
+        // Incompressible batch - store raw, marked by equal sizes
+        header.compressedSize = size;
+        payload = data;
+    }
+
+    m_sink->write(&header, sizeof(header));
+    m_sink->write(payload, header.compressedSize);
+
+    m_rawBytes += size;
+    m_compressedBytes += sizeof(header) + header.compressedSize;
+}
+
+void Lz4TraceSink::flush() {
+    m_sink->flush();
+}
+
+void Lz4TraceSink::decompressFrame(const Lz4FrameHeader &header,
+                                   const void *payload,
+                                   std::vector<char> &output) {
+    if (header.magic != LZ4_FRAME_MAGIC) {
+        throw Exception("Invalid LZ4 trace frame magic");
+    }
+
+    output.resize(header.rawSize);
+
+    if (header.compressedSize == header.rawSize) {
+        // Frame was stored raw
+        memcpy(output.data(), payload, header.rawSize);
+        return;
+    }
+
+    int result = LZ4_decompress_safe(static_cast<const char *>(payload),
+                                     output.data(), header.compressedSize,
+                                     output.size());
+    if (result < 0 || static_cast<uint32_t>(result) != header.rawSize) {
+        throw Exception("Corrupted LZ4 trace frame");
+    }
+}
+
+}  // namespace octf
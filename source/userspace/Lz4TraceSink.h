@@ -0,0 +1,91 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_LZ4TRACESINK_H
+#define SOURCE_USERSPACE_LZ4TRACESINK_H
+
+#include <memory>
+#include <vector>
+#include "TraceSink.h"
+
+namespace octf {
+
+/**
+ * @brief Header of one LZ4 frame in a compressed trace stream
+ *
+ * Each drained batch becomes one frame, so frames stay independently
+ * decompressible and a reader can resynchronize on the magic after
+ * a damaged frame.
+ */
+struct Lz4FrameHeader {
+    /** Frame marker, LZ4_FRAME_MAGIC */
+    uint32_t magic;
+
+    /** Size of the batch before compression */
+    uint32_t rawSize;
+
+    /** Size of the compressed payload following this header */
+    uint32_t compressedSize;
+} __attribute__((packed));
+
+/**
+ * @brief Trace sink stage compressing drained batches with LZ4
+ *
+ * Writes one LZ4 frame per batch into the wrapped sink. Batches which
+ * do not compress (compressed size >= raw size) are stored raw with
+ * compressedSize == rawSize, so decompression stays branch-simple.
+ */
+class Lz4TraceSink : public ITraceSink {
+public:
+    /** Frame marker value ("TLZ4") */
+    static const uint32_t LZ4_FRAME_MAGIC = 0x345A4C54;
+
+    /**
+     * @param sink Sink receiving the compressed stream
+     */
+    Lz4TraceSink(std::shared_ptr<ITraceSink> sink);
+    virtual ~Lz4TraceSink() = default;
+
+    void write(const void *data, size_t size) override;
+
+    void flush() override;
+
+    /**
+     * @brief Gets number of raw bytes submitted to this stage
+     */
+    uint64_t getRawBytes() const {
+        return m_rawBytes;
+    }
+
+    /**
+     * @brief Gets number of bytes after compression (including headers)
+     */
+    uint64_t getCompressedBytes() const {
+        return m_compressedBytes;
+    }
+
+    /**
+     * @brief Decompresses one frame of a compressed trace stream
+     *
+     * Used by the parsing path to transparently read compressed traces.
+     *
+     * @param header Frame header
+     * @param payload Frame payload (header.compressedSize bytes)
+     * @param[out] output Decompressed batch, resized to header.rawSize
+     */
+    static void decompressFrame(const Lz4FrameHeader &header,
+                                const void *payload,
+                                std::vector<char> &output);
+
+private:
+    std::shared_ptr<ITraceSink> m_sink;
+    std::vector<char> m_compressed;
+    uint64_t m_rawBytes;
+    uint64_t m_compressedBytes;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_LZ4TRACESINK_H
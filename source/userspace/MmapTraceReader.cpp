@@ -0,0 +1,53 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "MmapTraceReader.h"
+#include <fcntl.h>
+#include <octf/utils/Exception.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace octf {
+
+MmapTraceReader::MmapTraceReader(const std::string &path)
+        : m_data(nullptr)
+        , m_size(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw Exception("Cannot open trace shard " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info)) {
+        close(fd);
+        throw Exception("Cannot stat trace shard " + path);
+    }
+    m_size = info.st_size;
+
+    if (m_size) {
+        void *map = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            throw Exception("Cannot map trace shard " + path);
+        }
+        m_data = static_cast<const char *>(map);
+
+        // Forward scan - ask for aggressive readahead right away
+        madvise(map, m_size, MADV_SEQUENTIAL);
+        madvise(map, m_size, MADV_WILLNEED);
+    }
+
+    // The mapping keeps the file alive
+    close(fd);
+}
+
+MmapTraceReader::~MmapTraceReader() {
+    if (m_data) {
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+}
+
+}  // namespace octf
@@ -0,0 +1,56 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_MMAPTRACEREADER_H
+#define SOURCE_USERSPACE_MMAPTRACEREADER_H
+
+#include <cstddef>
+#include <string>
+
+namespace octf {
+
+/**
+ * @brief Read-only memory mapping of one trace file
+ *
+ * Maps the file shared, so repeated analyses and concurrent processes
+ * work off a single page cache copy instead of private read buffers,
+ * and a second pass over an already cached trace runs at memory
+ * bandwidth. The mapping is advised sequential and will-need up front -
+ * the parse path is a forward scan and wants readahead, not LRU.
+ *
+ * Consumers read events and frames in place through data(); the only
+ * copies left in the parse path are decompression output and the
+ * delta decode, which materialize by nature.
+ */
+class MmapTraceReader {
+public:
+    /**
+     * @param path Path of the mapped trace file
+     */
+    MmapTraceReader(const std::string &path);
+    virtual ~MmapTraceReader();
+
+    MmapTraceReader(const MmapTraceReader &) = delete;
+    MmapTraceReader &operator=(const MmapTraceReader &) = delete;
+
+    /**
+     * @brief Gets the mapped content, valid for the reader's lifetime
+     */
+    const char *data() const {
+        return m_data;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+private:
+    const char *m_data;
+    size_t m_size;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_MMAPTRACEREADER_H
@@ -0,0 +1,100 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "NumaTopology.h"
+#include <fstream>
+#include <sstream>
+
+namespace octf {
+
+static const char NODE_SYSFS_DIR[] = "/sys/devices/system/node";
+
+NumaTopology::NumaTopology()
+        : m_nodeCount(1)
+        , m_cpuNode() {
+    uint32_t node = 0;
+
+    for (;;) {
+        std::ostringstream path;
+        path << NODE_SYSFS_DIR << "/node" << node << "/cpulist";
+
+        std::ifstream file(path.str());
+        if (!file.is_open()) {
+            break;
+        }
+
+        std::string list;
+        std::getline(file, list);
+
+        for (uint32_t cpu : parseCpuList(list)) {
+            if (cpu >= m_cpuNode.size()) {
+                m_cpuNode.resize(cpu + 1, 0);
+            }
+            m_cpuNode[cpu] = node;
+        }
+
+        node++;
+    }
+
+    if (node) {
+        m_nodeCount = node;
+    }
+}
+
+uint32_t NumaTopology::getNodeOfCpu(uint32_t cpu) const {
+    if (cpu < m_cpuNode.size()) {
+        return m_cpuNode[cpu];
+    }
+
+    return 0;
+}
+
+bool NumaTopology::getNodeCpuSet(uint32_t node, cpu_set_t &cpuSet) const {
+    bool found = false;
+
+    CPU_ZERO(&cpuSet);
+    for (uint32_t cpu = 0; cpu < m_cpuNode.size(); cpu++) {
+        if (m_cpuNode[cpu] == node) {
+            CPU_SET(cpu, &cpuSet);
+            found = true;
+        }
+    }
+
+    if (!found) {
+        // No topology - leave the set full so affinity calls are no-ops
+        for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+
+    return found;
+}
+
+std::vector<uint32_t> NumaTopology::parseCpuList(const std::string &list) {
+    std::vector<uint32_t> cpus;
+    std::istringstream stream(list);
+    std::string range;
+
+    while (std::getline(stream, range, ',')) {
+        size_t dash = range.find('-');
+        try {
+            if (dash == std::string::npos) {
+                cpus.push_back(std::stoul(range));
+            } else {
+                uint32_t first = std::stoul(range.substr(0, dash));
+                uint32_t last = std::stoul(range.substr(dash + 1));
+                for (uint32_t cpu = first; cpu <= last; cpu++) {
+                    cpus.push_back(cpu);
+                }
+            }
+        } catch (const std::exception &) {
+            // Malformed sysfs entry - skip the range
+        }
+    }
+
+    return cpus;
+}
+
+}  // namespace octf
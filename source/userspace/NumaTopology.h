@@ -0,0 +1,69 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_NUMATOPOLOGY_H
+#define SOURCE_USERSPACE_NUMATOPOLOGY_H
+
+#include <sched.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace octf {
+
+/**
+ * @brief CPU to NUMA node mapping read from sysfs
+ *
+ * On hosts without NUMA information (or with it disabled) every CPU
+ * maps to node 0, so callers need no special casing.
+ */
+class NumaTopology {
+public:
+    NumaTopology();
+    virtual ~NumaTopology() = default;
+
+    /**
+     * @brief Gets number of NUMA nodes
+     */
+    uint32_t getNodeCount() const {
+        return m_nodeCount;
+    }
+
+    /**
+     * @brief Gets home node of given CPU
+     *
+     * @param cpu CPU id
+     *
+     * @return Node id, 0 when the CPU is unknown
+     */
+    uint32_t getNodeOfCpu(uint32_t cpu) const;
+
+    /**
+     * @brief Gets CPU set spanning given node
+     *
+     * @param node Node id
+     * @param[out] cpuSet CPUs of the node; all CPUs when the node has
+     *        no sysfs entry
+     *
+     * @retval true CPU set filled from topology
+     * @retval false No topology for the node, cpuSet left full
+     */
+    bool getNodeCpuSet(uint32_t node, cpu_set_t &cpuSet) const;
+
+private:
+    /**
+     * @brief Parses sysfs cpulist format ("0-3,8-11") into CPU ids
+     */
+    static std::vector<uint32_t> parseCpuList(const std::string &list);
+
+    uint32_t m_nodeCount;
+
+    /** CPU id indexed node map */
+    std::vector<uint32_t> m_cpuNode;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_NUMATOPOLOGY_H
@@ -0,0 +1,183 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ODirectFileSink.h"
+#include <fcntl.h>
+#include <octf/utils/Exception.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace octf {
+
+ODirectFileSink::ODirectFileSink(const std::string &path, size_t bufferSize)
+        : m_path(path)
+        , m_fd(-1)
+        , m_bufferSize(bufferSize)
+        , m_active(0)
+        , m_pending(-1)
+        , m_offset(0)
+        , m_logicalSize(0)
+        , m_stop(false)
+        , m_writerError(false) {
+    if (m_bufferSize % DIRECT_IO_ALIGNMENT) {
+        throw Exception("Direct IO buffer size must be aligned");
+    }
+
+    m_buffers[0] = m_buffers[1] = nullptr;
+    m_fill[0] = m_fill[1] = 0;
+    m_busy[0] = m_busy[1] = false;
+
+    m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if (m_fd == -1) {
+        throw Exception("Failed to open trace output file for direct IO: " +
+                        path);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        void *buffer;
+        if (posix_memalign(&buffer, DIRECT_IO_ALIGNMENT, m_bufferSize)) {
+            free(m_buffers[0]);
+            close(m_fd);
+            throw Exception("Failed to allocate direct IO buffers");
+        }
+        m_buffers[i] = static_cast<char *>(buffer);
+    }
+
+    m_writer = std::thread(&ODirectFileSink::writerLoop, this);
+}
+
+ODirectFileSink::~ODirectFileSink() {
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stop = true;
+    }
+    m_submitCv.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+
+    free(m_buffers[0]);
+    free(m_buffers[1]);
+    if (m_fd != -1) {
+        close(m_fd);
+    }
+}
+
+void ODirectFileSink::write(const void *data, size_t size) {
+    const char *input = static_cast<const char *>(data);
+
+    checkWriterError();
+
+    while (size) {
+        size_t space = m_bufferSize - m_fill[m_active];
+        size_t chunk = size < space ? size : space;
+
+        memcpy(m_buffers[m_active] + m_fill[m_active], input, chunk);
+        m_fill[m_active] += chunk;
+        m_logicalSize += chunk;
+        input += chunk;
+        size -= chunk;
+
+        if (m_fill[m_active] == m_bufferSize) {
+            submitActiveBuffer();
+        }
+    }
+}
+
+void ODirectFileSink::submitActiveBuffer() {
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    // Hand the filled buffer over and continue filling the other one;
+    // block only if that one is still behind the device
+    while (m_pending != -1 && !m_writerError) {
+        m_doneCv.wait(lock);
+    }
+    if (m_writerError) {
+        lock.unlock();
+        checkWriterError();
+    }
+
+    m_pending = m_active;
+    m_busy[m_active] = true;
+    m_submitCv.notify_one();
+
+    m_active ^= 1;
+    while (m_busy[m_active] && !m_writerError) {
+        m_doneCv.wait(lock);
+    }
+    m_fill[m_active] = 0;
+}
+
+void ODirectFileSink::flush() {
+    // Finalize: pad the tail to the direct IO alignment, wait for all
+    // writes and trim the file back to the payload size
+    if (m_fill[m_active]) {
+        size_t padded =
+                (m_fill[m_active] + DIRECT_IO_ALIGNMENT - 1) &
+                ~(DIRECT_IO_ALIGNMENT - 1);
+        memset(m_buffers[m_active] + m_fill[m_active], 0,
+               padded - m_fill[m_active]);
+        m_fill[m_active] = padded;
+
+        submitActiveBuffer();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        while ((m_pending != -1 || m_busy[0] || m_busy[1]) &&
+               !m_writerError) {
+            m_doneCv.wait(lock);
+        }
+    }
+    checkWriterError();
+
+    if (ftruncate(m_fd, m_logicalSize)) {
+        throw Exception("Failed to trim trace output file: " + m_path);
+    }
+}
+
+void ODirectFileSink::checkWriterError() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_writerError) {
+        throw Exception("Direct IO write failed on trace output file: " +
+                        m_path);
+    }
+}
+
+void ODirectFileSink::writerLoop() {
+    for (;;) {
+        int index;
+        size_t size;
+
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            while (m_pending == -1 && !m_stop) {
+                m_submitCv.wait(lock);
+            }
+            if (m_pending == -1 && m_stop) {
+                break;
+            }
+            index = m_pending;
+            m_pending = -1;
+            size = m_fill[index];
+        }
+
+        ssize_t result = pwrite(m_fd, m_buffers[index], size, m_offset);
+
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (result != static_cast<ssize_t>(size)) {
+                m_writerError = true;
+            } else {
+                m_offset += size;
+            }
+            m_busy[index] = false;
+        }
+        m_doneCv.notify_all();
+    }
+}
+
+}  // namespace octf
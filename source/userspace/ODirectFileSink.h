@@ -0,0 +1,104 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_ODIRECTFILESINK_H
+#define SOURCE_USERSPACE_ODIRECTFILESINK_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "TraceSink.h"
+
+namespace octf {
+
+/**
+ * @brief Trace sink writing through O_DIRECT with double buffering
+ *
+ * Keeps the tracer's output out of the page cache so a capture does not
+ * evict the cache whose behavior is being measured, and its writeback
+ * does not compete with the traced devices. Batches fill one aligned
+ * buffer while the other is in flight on a background writer thread;
+ * the drain path blocks only when both buffers are behind the device.
+ *
+ * flush() finalizes the file: the partial tail is written padded to the
+ * alignment and the file is truncated back to the logical size, so it
+ * is meant to be called once when the capture ends (or a segment is
+ * closed), not periodically.
+ */
+class ODirectFileSink : public ITraceSink {
+public:
+    /** Alignment of direct I/O buffers and sizes */
+    static const size_t DIRECT_IO_ALIGNMENT = 4096;
+
+    /**
+     * @param path Output file path, created or truncated
+     * @param bufferSize Size of each of the two aligned buffers
+     */
+    ODirectFileSink(const std::string &path,
+                    size_t bufferSize = 8 * 1024 * 1024);
+    virtual ~ODirectFileSink();
+
+    void write(const void *data, size_t size) override;
+
+    void flush() override;
+
+    /**
+     * @brief Gets number of payload bytes written so far
+     */
+    uint64_t getWrittenBytes() const {
+        return m_logicalSize;
+    }
+
+private:
+    /**
+     * @brief Background thread writing submitted buffers to the file
+     */
+    void writerLoop();
+
+    /**
+     * @brief Hands the active buffer to the writer thread
+     *
+     * Blocks until the other buffer is free to fill.
+     */
+    void submitActiveBuffer();
+
+    /**
+     * @brief Throws if the writer thread hit an error
+     */
+    void checkWriterError();
+
+    std::string m_path;
+    int m_fd;
+    size_t m_bufferSize;
+
+    /** Two aligned fill buffers */
+    char *m_buffers[2];
+    size_t m_fill[2];
+    bool m_busy[2];
+
+    /** Buffer currently being filled by the drain path */
+    int m_active;
+
+    /** Buffer index handed over to the writer thread, -1 if none */
+    int m_pending;
+
+    /** File offset of the next buffer write */
+    uint64_t m_offset;
+
+    /** Payload bytes accepted so far */
+    uint64_t m_logicalSize;
+
+    std::mutex m_lock;
+    std::condition_variable m_submitCv;
+    std::condition_variable m_doneCv;
+    std::thread m_writer;
+    bool m_stop;
+    bool m_writerError;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_ODIRECTFILESINK_H
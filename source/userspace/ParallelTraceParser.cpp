@@ -0,0 +1,549 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ParallelTraceParser.h"
+#include <octf/utils/Exception.h>
+#include <octf/utils/Log.h>
+#include <algorithm>
+#include <cstring>
+#include "Crc32c.h"
+#include "CrcTraceSink.h"
+#include "Lz4TraceSink.h"
+#include "MmapTraceReader.h"
+#include "TraceFormatV2.h"
+#include "TraceIndex.h"
+
+namespace octf {
+
+EventBlockQueue::EventBlockQueue() : m_head(0), m_tail(0) {}
+
+void EventBlockQueue::push(std::vector<char> &&block) {
+    uint32_t head = m_head.load(std::memory_order_relaxed);
+
+    while (head - m_tail.load(std::memory_order_acquire) == DEPTH) {
+        std::this_thread::yield();
+    }
+
+    m_slots[head % DEPTH] = std::move(block);
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+void EventBlockQueue::pop(std::vector<char> &block) {
+    uint32_t tail = m_tail.load(std::memory_order_relaxed);
+
+    while (m_head.load(std::memory_order_acquire) == tail) {
+        std::this_thread::yield();
+    }
+
+    block = std::move(m_slots[tail % DEPTH]);
+    m_tail.store(tail + 1, std::memory_order_release);
+}
+
+namespace {
+
+/**
+ * @brief Byte stream over one mapped shard file, de-framing CRC32C
+ *        integrity frames and LZ4 transparently
+ *
+ * Three layers, each optional per shard: CRC frames are verified in
+ * place over the mapping and damaged frames are skipped by
+ * resynchronizing on the next magic; LZ4 frames decompress straight
+ * from the verified bytes; raw content is served in place - view()
+ * hands out pointers into the mapping (or the decompressed frame) and
+ * only stages reads straddling a frame boundary.
+ */
+class ShardStream {
+public:
+    ShardStream(const std::string &path, uint64_t seekOffset = 0)
+            : m_map(path)
+            , m_path(path)
+            , m_cursor(seekOffset)
+            , m_crc(false)
+            , m_lz4(false)
+            , m_crcFn(getCrc32c())
+            , m_span(nullptr)
+            , m_spanSize(0)
+            , m_spanOffset(0)
+            , m_pending()
+            , m_offset(0) {
+        // Probe the framing by the leading magics; CRC is outermost
+        size_t inner = 0;
+        if (peekMagic(0) == CrcTraceSink::CRC_FRAME_MAGIC) {
+            m_crc = true;
+            inner = sizeof(CrcFrameHeader);
+        }
+        m_lz4 = (peekMagic(inner) == Lz4TraceSink::LZ4_FRAME_MAGIC);
+        // Index checkpoints record batch (and frame) boundaries, so a
+        // nonzero cursor still lands on full headers
+    }
+
+    /**
+     * @brief Reads exactly size bytes
+     *
+     * @retval true Bytes read
+     * @retval false Clean end of stream before the first byte
+     */
+    bool read(void *dst, size_t size) {
+        if (!m_lz4) {
+            return spanRead(dst, size);
+        }
+
+        char *out = static_cast<char *>(dst);
+        size_t done = 0;
+
+        while (done < size) {
+            if (m_offset == m_pending.size() && !fill()) {
+                if (!done) {
+                    return false;
+                }
+                throw Exception("Truncated trace shard " + m_path);
+            }
+
+            size_t chunk = std::min(size - done, m_pending.size() - m_offset);
+            std::memcpy(out + done, m_pending.data() + m_offset, chunk);
+            m_offset += chunk;
+            done += chunk;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Gets size contiguous bytes without copying when possible
+     *
+     * @return Pointer valid until the next stream call, NULL on clean
+     *         end of stream
+     */
+    const char *view(size_t size) {
+        if (!m_lz4) {
+            return spanView(size, m_staging);
+        }
+
+        if (m_offset == m_pending.size() && !fill()) {
+            return nullptr;
+        }
+
+        if (m_pending.size() - m_offset >= size) {
+            const char *ptr = m_pending.data() + m_offset;
+            m_offset += size;
+            return ptr;
+        }
+
+        m_staging.resize(size);
+        read(m_staging.data(), size);
+        return m_staging.data();
+    }
+
+private:
+    /**
+     * @brief Reads the magic candidate at a mapping offset
+     */
+    uint32_t peekMagic(size_t offset) const {
+        uint32_t magic = 0;
+
+        if (m_map.size() >= offset + sizeof(magic)) {
+            std::memcpy(&magic, m_map.data() + offset, sizeof(magic));
+        }
+        return magic;
+    }
+
+    /**
+     * @brief Advances to the next verified span of the mapping
+     *
+     * Without CRC framing the single span is the whole rest of the
+     * mapping. With it, each span is one verified frame payload served
+     * in place; frames failing verification are skipped by scanning for
+     * the next magic - the sid gap marks the loss.
+     */
+    bool nextSpan() {
+        for (;;) {
+            size_t remaining = m_map.size() - m_cursor;
+
+            if (!remaining) {
+                return false;
+            }
+
+            if (!m_crc) {
+                m_span = m_map.data() + m_cursor;
+                m_spanSize = remaining;
+                m_spanOffset = 0;
+                m_cursor = m_map.size();
+                return true;
+            }
+
+            CrcFrameHeader header;
+            if (remaining < sizeof(header)) {
+                resync("truncated frame header");
+                continue;
+            }
+            std::memcpy(&header, m_map.data() + m_cursor, sizeof(header));
+
+            if (header.magic != CrcTraceSink::CRC_FRAME_MAGIC ||
+                remaining - sizeof(header) < header.length) {
+                resync("damaged frame header");
+                continue;
+            }
+
+            const char *payload = m_map.data() + m_cursor + sizeof(header);
+            if (m_crcFn(payload, header.length) != header.crc) {
+                resync("frame checksum mismatch");
+                continue;
+            }
+
+            m_span = payload;
+            m_spanSize = header.length;
+            m_spanOffset = 0;
+            m_cursor += sizeof(header) + header.length;
+            return true;
+        }
+    }
+
+    /**
+     * @brief Skips to the next frame magic after a damaged frame
+     */
+    void resync(const char *reason) {
+        uint32_t magic = CrcTraceSink::CRC_FRAME_MAGIC;
+        size_t pos = m_cursor + 1;
+
+        while (pos + sizeof(magic) <= m_map.size() &&
+               std::memcmp(m_map.data() + pos, &magic, sizeof(magic))) {
+            pos++;
+        }
+        if (pos + sizeof(magic) > m_map.size()) {
+            pos = m_map.size();
+        }
+
+        log::cerr << "Trace shard " << m_path << ": " << reason
+                  << ", skipped " << pos - m_cursor << " bytes"
+                  << std::endl;
+        m_cursor = pos;
+    }
+
+    bool spanEnsure() {
+        return m_spanOffset < m_spanSize || nextSpan();
+    }
+
+    bool spanRead(void *dst, size_t size) {
+        char *out = static_cast<char *>(dst);
+        size_t done = 0;
+
+        while (done < size) {
+            if (!spanEnsure()) {
+                if (!done) {
+                    return false;
+                }
+                throw Exception("Truncated trace shard " + m_path);
+            }
+
+            size_t chunk = std::min(size - done, m_spanSize - m_spanOffset);
+            std::memcpy(out + done, m_span + m_spanOffset, chunk);
+            m_spanOffset += chunk;
+            done += chunk;
+        }
+
+        return true;
+    }
+
+    const char *spanView(size_t size, std::vector<char> &staging) {
+        if (!spanEnsure()) {
+            return nullptr;
+        }
+
+        if (m_spanSize - m_spanOffset >= size) {
+            const char *ptr = m_span + m_spanOffset;
+            m_spanOffset += size;
+            return ptr;
+        }
+
+        staging.resize(size);
+        spanRead(staging.data(), size);
+        return staging.data();
+    }
+
+    /**
+     * @brief Decompresses the next frame into the pending window
+     *
+     * Only the LZ4 path stages anything; raw shards never come here.
+     */
+    bool fill() {
+        Lz4FrameHeader header;
+        if (!spanRead(&header, sizeof(header))) {
+            return false;
+        }
+        if (header.magic != Lz4TraceSink::LZ4_FRAME_MAGIC) {
+            throw Exception("Damaged trace shard " + m_path);
+        }
+
+        // Own staging - view() may be mid-copy into m_staging already
+        const char *payload = spanView(header.compressedSize, m_frame);
+        if (!payload) {
+            throw Exception("Truncated trace shard " + m_path);
+        }
+
+        Lz4TraceSink::decompressFrame(header, payload, m_pending);
+        m_offset = 0;
+        return true;
+    }
+
+    MmapTraceReader m_map;
+    std::string m_path;
+
+    /** Consumed bytes of the mapping */
+    size_t m_cursor;
+
+    bool m_crc;
+    bool m_lz4;
+
+    /** CRC implementation, resolved once per machine */
+    Crc32cFn m_crcFn;
+
+    /** Current verified span of the mapping */
+    const char *m_span;
+    size_t m_spanSize;
+    size_t m_spanOffset;
+
+    /** Current decompressed frame (LZ4 shards only) */
+    std::vector<char> m_pending;
+    size_t m_offset;
+
+    /** Fallbacks for reads straddling a frame boundary */
+    std::vector<char> m_staging;
+    std::vector<char> m_frame;
+};
+
+/**
+ * @brief Orders events by (timestamp, sid)
+ */
+bool eventBefore(const struct iotrace_event_hdr *a,
+                 const struct iotrace_event_hdr *b) {
+    if (a->timestamp != b->timestamp) {
+        return a->timestamp < b->timestamp;
+    }
+    return a->sid < b->sid;
+}
+
+}  // namespace
+
+ParallelTraceParser::ParallelTraceParser(
+        const std::vector<std::string> &shardPaths)
+        : m_shardPaths(shardPaths)
+        , m_queues()
+        , m_workers()
+        , m_workerError()
+        , m_errorLock()
+        , m_begin(0)
+        , m_end(UINT64_MAX)
+        , m_events(0)
+        , m_clockSource(TraceFormatV2::CLOCK_KTIME)
+        , m_clockRaw(0)
+        , m_clockReal(0) {
+    if (m_shardPaths.empty()) {
+        throw Exception("No trace shards to parse");
+    }
+}
+
+void ParallelTraceParser::setTimeRange(uint64_t begin, uint64_t end) {
+    if (begin > end) {
+        throw Exception("Invalid trace time range");
+    }
+    m_begin = begin;
+    m_end = end;
+}
+
+void ParallelTraceParser::decodeShard(uint32_t shard) {
+    try {
+        uint64_t seekOffset = 0;
+
+        if (m_begin) {
+            // Enter the shard at the last index checkpoint before the
+            // range; shards without a sidecar scan from the beginning
+            TraceIndex index(m_shardPaths[shard] + TraceIndexWriter::SUFFIX);
+            seekOffset = index.findOffset(m_begin);
+        }
+
+        ShardStream stream(m_shardPaths[shard], seekOffset);
+
+        if (!seekOffset) {
+            TraceFormatV2::FileHeader header = {};
+            if (!stream.read(&header,
+                             TraceFormatV2::FILE_HEADER_V20_SIZE)) {
+                throw Exception("Empty trace shard " + m_shardPaths[shard]);
+            }
+            if (header.magic != TraceFormatV2::FILE_MAGIC ||
+                header.versionMajor != TraceFormatV2::VERSION_MAJOR) {
+                throw Exception("Unsupported trace format in shard " +
+                                m_shardPaths[shard]);
+            }
+            // Clock fields exist since minor 1
+            if (header.versionMinor >= 1 &&
+                !stream.read(&header.clockSource,
+                             sizeof(header) -
+                                     TraceFormatV2::FILE_HEADER_V20_SIZE)) {
+                throw Exception("Truncated trace shard " +
+                                m_shardPaths[shard]);
+            }
+
+            // Shards of one capture share the clock; the first one is
+            // as good as any
+            if (!shard) {
+                m_clockSource = header.clockSource;
+                m_clockRaw = header.clockRaw;
+                m_clockReal = header.clockReal;
+            }
+        }
+
+        std::vector<char> decoded;
+
+        for (;;) {
+            // Varint batch length prefix; end of stream is only legal here
+            uint64_t length = 0;
+            int shift = 0;
+            uint8_t byte;
+
+            if (!stream.read(&byte, 1)) {
+                break;
+            }
+            for (;;) {
+                length |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    break;
+                }
+                shift += 7;
+                if (shift >= 64 || !stream.read(&byte, 1)) {
+                    throw Exception("Truncated trace shard " +
+                                    m_shardPaths[shard]);
+                }
+            }
+
+            // The batch decodes straight out of the mapping (or the
+            // decompressed frame) - no staging copy
+            const char *encoded = stream.view(length);
+            if (!encoded) {
+                throw Exception("Truncated trace shard " +
+                                m_shardPaths[shard]);
+            }
+
+            TraceFormatV2::decodeBatch(encoded, length, decoded);
+            if (!decoded.empty()) {
+                const struct iotrace_event_hdr *first =
+                        reinterpret_cast<const struct iotrace_event_hdr *>(
+                                decoded.data());
+
+                // Batches are time ordered - once past the range end
+                // the rest of the shard is of no interest
+                if (first->timestamp > m_end) {
+                    break;
+                }
+
+                m_queues[shard]->push(std::move(decoded));
+                decoded.clear();
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> guard(m_errorLock);
+        if (!m_workerError) {
+            m_workerError = std::current_exception();
+        }
+    }
+
+    // End of shard marker
+    m_queues[shard]->push(std::vector<char>());
+}
+
+bool ParallelTraceParser::advance(uint32_t shard, ShardCursor &cursor) {
+    if (cursor.done) {
+        return false;
+    }
+
+    if (!cursor.block.empty()) {
+        cursor.offset += cursor.head()->size;
+    }
+
+    while (cursor.offset >= cursor.block.size()) {
+        m_queues[shard]->pop(cursor.block);
+        cursor.offset = 0;
+        if (cursor.block.empty()) {
+            cursor.done = true;
+            return false;
+        }
+    }
+
+    if (!cursor.head()->size) {
+        throw Exception("Malformed event in shard " + m_shardPaths[shard]);
+    }
+
+    return true;
+}
+
+void ParallelTraceParser::parse(EventHandler handler) {
+    uint32_t shards = m_shardPaths.size();
+
+    m_queues.clear();
+    for (uint32_t shard = 0; shard < shards; shard++) {
+        m_queues.emplace_back(new EventBlockQueue());
+    }
+
+    for (uint32_t shard = 0; shard < shards; shard++) {
+        m_workers.emplace_back(&ParallelTraceParser::decodeShard, this,
+                               shard);
+    }
+
+    std::vector<ShardCursor> cursors(shards);
+    std::vector<bool> valid(shards);
+
+    try {
+        for (uint32_t shard = 0; shard < shards; shard++) {
+            valid[shard] = advance(shard, cursors[shard]);
+        }
+
+        // K-way merge on the queue heads; shards are internally ordered
+        for (;;) {
+            int best = -1;
+
+            for (uint32_t shard = 0; shard < shards; shard++) {
+                if (valid[shard] &&
+                    (best < 0 || eventBefore(cursors[shard].head(),
+                                             cursors[best].head()))) {
+                    best = shard;
+                }
+            }
+            if (best < 0) {
+                break;
+            }
+
+            const struct iotrace_event_hdr *event = cursors[best].head();
+            if (event->timestamp >= m_begin && event->timestamp <= m_end) {
+                handler(event);
+                m_events++;
+            }
+
+            valid[best] = advance(best, cursors[best]);
+        }
+    } catch (...) {
+        // Unblock workers waiting on full queues before rejoining
+        for (uint32_t shard = 0; shard < shards; shard++) {
+            while (!cursors[shard].done) {
+                m_queues[shard]->pop(cursors[shard].block);
+                cursors[shard].done = cursors[shard].block.empty();
+            }
+        }
+        for (auto &worker : m_workers) {
+            worker.join();
+        }
+        m_workers.clear();
+        throw;
+    }
+
+    for (auto &worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+
+    if (m_workerError) {
+        std::rethrow_exception(m_workerError);
+    }
+}
+
+}  // namespace octf
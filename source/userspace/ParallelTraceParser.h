@@ -0,0 +1,194 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_PARALLELTRACEPARSER_H
+#define SOURCE_USERSPACE_PARALLELTRACEPARSER_H
+
+#include <octf/trace/iotrace_event.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace octf {
+
+/**
+ * @brief Lock-free bounded queue of decoded event blocks
+ *
+ * Single producer (a decode worker), single consumer (the merger), so
+ * a plain atomic head/tail ring suffices - no locks on the parse hot
+ * path.
+ */
+class EventBlockQueue {
+public:
+    /** Queue depth; bounds memory to depth * block size per shard */
+    static const uint32_t DEPTH = 64;
+
+    EventBlockQueue();
+
+    /**
+     * @brief Pushes one block, blocking while the queue is full
+     *
+     * @param block Block content, taken over by the queue
+     */
+    void push(std::vector<char> &&block);
+
+    /**
+     * @brief Pops one block, blocking while the queue is empty
+     *
+     * @param[out] block Popped block; empty block signals end of shard
+     */
+    void pop(std::vector<char> &block);
+
+private:
+    std::vector<char> m_slots[DEPTH];
+
+    /** Next slot to fill (producer owned) */
+    std::atomic<uint32_t> m_head;
+
+    /** Next slot to drain (consumer owned) */
+    std::atomic<uint32_t> m_tail;
+};
+
+/**
+ * @brief Parallel parser for v2 trace shards
+ *
+ * Shards (one file per capture queue or NUMA node) are independent,
+ * time-ordered event streams. One decode worker per shard reads,
+ * decompresses and delta-decodes its file into fixed-width events and
+ * feeds a bounded queue; the calling thread k-way merges the queue
+ * heads by (timestamp, sid) and hands out one globally ordered event
+ * stream. Decoding - the dominant cost - scales with the shard count.
+ *
+ * LZ4 compressed shards (LZ4_FRAME_MAGIC leading) are decompressed
+ * transparently.
+ */
+class ParallelTraceParser {
+public:
+    /**
+     * @brief Receiver of merged events, called in global trace order
+     */
+    typedef std::function<void(const struct iotrace_event_hdr *event)>
+            EventHandler;
+
+    /**
+     * @param shardPaths Paths of the shard files forming one trace
+     */
+    ParallelTraceParser(const std::vector<std::string> &shardPaths);
+    virtual ~ParallelTraceParser() = default;
+
+    /**
+     * @brief Parses all shards, invoking handler per event in order
+     *
+     * Blocks until all shards are exhausted. Throws on malformed input.
+     *
+     * @param handler Merged event receiver
+     */
+    void parse(EventHandler handler);
+
+    /**
+     * @brief Restricts parsing to a time range
+     *
+     * Shards with an index sidecar (<path> + ".index") are entered at
+     * the last checkpoint before the range begin instead of offset 0;
+     * workers stop decoding once past the range end. Without a sidecar
+     * the shard is scanned but only in-range events are emitted.
+     *
+     * @param begin First timestamp of interest
+     * @param end Last timestamp of interest (inclusive)
+     */
+    void setTimeRange(uint64_t begin, uint64_t end);
+
+    /**
+     * @brief Gets number of events emitted so far
+     */
+    uint64_t getParsedEvents() const {
+        return m_events;
+    }
+
+    /**
+     * @brief Gets the timestamp source of the trace
+     *
+     * Valid after parse() started reading. Traces taken with the raw
+     * sched clock need their timestamps normalized via the calibration
+     * pair; ktime traces are already corrected monotonic time.
+     *
+     * @return TraceFormatV2::ClockSource value
+     */
+    uint8_t getClockSource() const {
+        return m_clockSource;
+    }
+
+    /**
+     * @brief Gets the clock calibration pair of the trace
+     *
+     * @param[out] raw Event clock reading at capture start
+     * @param[out] real CLOCK_REALTIME ns at the same instant
+     */
+    void getClockCalibration(uint64_t &raw, uint64_t &real) const {
+        raw = m_clockRaw;
+        real = m_clockReal;
+    }
+
+private:
+    /**
+     * @brief Decode worker body for one shard
+     */
+    void decodeShard(uint32_t shard);
+
+    /**
+     * @brief Cursor over the current block of one shard
+     */
+    struct ShardCursor {
+        /** Current decoded block */
+        std::vector<char> block;
+
+        /** Offset of the head event within block */
+        size_t offset = 0;
+
+        /** Shard fully drained */
+        bool done = false;
+
+        const struct iotrace_event_hdr *head() const {
+            return reinterpret_cast<const struct iotrace_event_hdr *>(
+                    block.data() + offset);
+        }
+    };
+
+    /**
+     * @brief Advances cursor to its next event, refilling from queue
+     *
+     * @retval true Cursor head is valid
+     * @retval false Shard exhausted
+     */
+    bool advance(uint32_t shard, ShardCursor &cursor);
+
+    std::vector<std::string> m_shardPaths;
+    std::vector<std::unique_ptr<EventBlockQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    /** First error thrown by a decode worker, rethrown by parse() */
+    std::exception_ptr m_workerError;
+    std::mutex m_errorLock;
+
+    /** Emitted time range, full range by default */
+    uint64_t m_begin;
+    uint64_t m_end;
+
+    std::atomic<uint64_t> m_events;
+
+    /** Clock info from the shard headers (written only by the worker of
+     *  shard 0, read after parse() returns) */
+    uint8_t m_clockSource;
+    uint64_t m_clockRaw;
+    uint64_t m_clockReal;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_PARALLELTRACEPARSER_H
@@ -0,0 +1,199 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "RingPoller.h"
+#include <octf/utils/Exception.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cstdint>
+#include <string>
+
+namespace octf {
+
+RingPoller &RingPoller::get() {
+    static RingPoller poller;
+    return poller;
+}
+
+RingPoller::RingPoller()
+        : m_epollFd(-1)
+        , m_wakeupFd(-1)
+        , m_running(false) {
+    m_epollFd = epoll_create1(0);
+    if (m_epollFd == -1) {
+        throw Exception("Failed to create epoll instance for trace rings");
+    }
+
+    m_wakeupFd = eventfd(0, EFD_NONBLOCK);
+    if (m_wakeupFd == -1) {
+        close(m_epollFd);
+        throw Exception("Failed to create poller wakeup fd");
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = m_wakeupFd;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeupFd, &event)) {
+        close(m_wakeupFd);
+        close(m_epollFd);
+        throw Exception("Failed to register poller wakeup fd");
+    }
+}
+
+RingPoller::~RingPoller() {
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_running = false;
+    }
+    wakeupPoller();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    close(m_wakeupFd);
+    close(m_epollFd);
+}
+
+void RingPoller::addRing(int fd) {
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    // Rings are registered disarmed (no EPOLLIN yet) - the consumer arms
+    // its ring upon the first waitForData() call.
+    struct epoll_event event = {};
+    event.events = EPOLLONESHOT;
+    event.data.fd = fd;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event)) {
+        throw Exception("Failed to register trace ring fd " +
+                        std::to_string(fd));
+    }
+
+    m_waiters[fd] = std::unique_ptr<Waiter>(new Waiter());
+
+    if (!m_running) {
+        m_running = true;
+        m_thread = std::thread(&RingPoller::run, this);
+    }
+}
+
+void RingPoller::removeRing(int fd) {
+    std::thread toJoin;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        auto iter = m_waiters.find(fd);
+        if (iter == m_waiters.end()) {
+            return;
+        }
+
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, NULL);
+
+        // Unblock a consumer possibly parked on this ring
+        {
+            std::lock_guard<std::mutex> waiterGuard(iter->second->lock);
+            iter->second->ready = true;
+        }
+        iter->second->cv.notify_all();
+
+        m_waiters.erase(iter);
+
+        if (m_waiters.empty() && m_running) {
+            m_running = false;
+            toJoin = std::move(m_thread);
+        }
+    }
+
+    if (toJoin.joinable()) {
+        wakeupPoller();
+        toJoin.join();
+    }
+}
+
+bool RingPoller::waitForData(
+        int fd,
+        std::chrono::time_point<std::chrono::steady_clock> deadline) {
+    Waiter *waiter;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        auto iter = m_waiters.find(fd);
+        if (iter == m_waiters.end()) {
+            return false;
+        }
+        waiter = iter->second.get();
+    }
+
+    std::unique_lock<std::mutex> waiterLock(waiter->lock);
+    waiter->ready = false;
+
+    // Re-arm the one-shot watch now that the consumer wants more data
+    armRing(fd);
+
+    while (!waiter->ready) {
+        if (waiter->cv.wait_until(waiterLock, deadline) ==
+            std::cv_status::timeout) {
+            return waiter->ready;
+        }
+    }
+
+    return true;
+}
+
+void RingPoller::armRing(int fd) {
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.fd = fd;
+    epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &event);
+}
+
+void RingPoller::wakeupPoller() {
+    uint64_t one = 1;
+    ssize_t result = write(m_wakeupFd, &one, sizeof(one));
+    (void) result;
+}
+
+void RingPoller::run() {
+    const int MAX_EVENTS = 64;
+    struct epoll_event events[MAX_EVENTS];
+
+    for (;;) {
+        int count = epoll_wait(m_epollFd, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        if (!m_running) {
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+
+            if (fd == m_wakeupFd) {
+                uint64_t value;
+                ssize_t result = read(m_wakeupFd, &value, sizeof(value));
+                (void) result;
+                continue;
+            }
+
+            auto iter = m_waiters.find(fd);
+            if (iter == m_waiters.end()) {
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> waiterGuard(iter->second->lock);
+                iter->second->ready = true;
+            }
+            iter->second->cv.notify_one();
+        }
+    }
+}
+
+}  // namespace octf
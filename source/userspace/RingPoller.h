@@ -0,0 +1,119 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_RINGPOLLER_H
+#define SOURCE_USERSPACE_RINGPOLLER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace octf {
+
+/**
+ * @brief Process wide poller for kernel trace ring files
+ *
+ * All per-CPU trace ring file descriptors are watched by one epoll
+ * instance serviced by a single thread. Consumer threads park on a
+ * per-ring condition variable instead of each issuing its own select(),
+ * so an idle 256-ring host costs one sleeping syscall instead of 256.
+ *
+ * Rings are armed one-shot: a ring reported ready is not watched again
+ * until its consumer comes back for more data, which prevents the poller
+ * thread from spinning on a ring that is still being drained.
+ */
+class RingPoller {
+public:
+    /**
+     * @brief Gets poller singleton
+     */
+    static RingPoller &get();
+
+    /**
+     * @brief Registers trace ring file descriptor with the poller
+     *
+     * The poller thread is started upon registering the first ring.
+     *
+     * @param fd Trace ring file descriptor
+     */
+    void addRing(int fd);
+
+    /**
+     * @brief Unregisters trace ring file descriptor
+     *
+     * The poller thread is stopped when the last ring is removed.
+     *
+     * @param fd Trace ring file descriptor
+     */
+    void removeRing(int fd);
+
+    /**
+     * @brief Waits until the ring has data ready or the deadline passes
+     *
+     * @param fd Trace ring file descriptor
+     * @param deadline Absolute wait deadline
+     *
+     * @retval true Ring has events ready to be read
+     * @retval false Deadline reached
+     */
+    bool waitForData(int fd,
+                     std::chrono::time_point<std::chrono::steady_clock>
+                             deadline);
+
+private:
+    RingPoller();
+    ~RingPoller();
+    RingPoller(const RingPoller &) = delete;
+    RingPoller &operator=(const RingPoller &) = delete;
+
+    /**
+     * @brief Per-ring parking slot for the consumer thread
+     */
+    struct Waiter {
+        std::mutex lock;
+        std::condition_variable cv;
+        bool ready = false;
+    };
+
+    /**
+     * @brief Poller thread body - dispatches epoll events to waiters
+     */
+    void run();
+
+    /**
+     * @brief Re-arms one-shot watch on given ring
+     */
+    void armRing(int fd);
+
+    /**
+     * @brief Kicks the poller thread out of epoll_wait
+     */
+    void wakeupPoller();
+
+    /** Epoll instance watching all registered rings */
+    int m_epollFd;
+
+    /** Event fd used to interrupt epoll_wait on shutdown */
+    int m_wakeupFd;
+
+    /** Registered rings with their parked consumers */
+    std::map<int, std::unique_ptr<Waiter>> m_waiters;
+
+    /** Protects m_waiters and thread lifecycle */
+    std::mutex m_lock;
+
+    /** Thread servicing the epoll instance */
+    std::thread m_thread;
+
+    /** Set to request poller thread exit */
+    bool m_running;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_RINGPOLLER_H
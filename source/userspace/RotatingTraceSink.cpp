@@ -0,0 +1,221 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "RotatingTraceSink.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <octf/utils/Exception.h>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include "CrcTraceSink.h"
+#include "FileTraceSink.h"
+#include "Lz4TraceSink.h"
+
+namespace octf {
+
+static uint64_t fileSize(const std::string &path) {
+    struct stat info;
+
+    if (::stat(path.c_str(), &info)) {
+        return 0;
+    }
+
+    return info.st_size;
+}
+
+RotatingTraceSink::RotatingTraceSink(const Config &config,
+                                     SegmentFactory factory)
+        : m_config(config)
+        , m_factory(factory)
+        , m_current()
+        , m_currentPath()
+        , m_currentBytes(0)
+        , m_currentOpened()
+        , m_sequence(0)
+        , m_rotations(0)
+        , m_finished()
+        , m_finishedBytes(0)
+        , m_pending()
+        , m_lock()
+        , m_work()
+        , m_stopping(false)
+        , m_worker() {
+    if (!m_factory) {
+        throw Exception("No segment factory provided");
+    }
+    if (m_config.dir.empty()) {
+        throw Exception("No output directory for continuous tracing");
+    }
+
+    openSegment();
+    m_worker = std::thread(&RotatingTraceSink::maintenanceLoop, this);
+}
+
+RotatingTraceSink::~RotatingTraceSink() {
+    if (m_current) {
+        m_current->flush();
+        m_current.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        // Last segment stays uncompressed - it may still be inspected
+        m_stopping = true;
+    }
+    m_work.notify_all();
+
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+void RotatingTraceSink::openSegment() {
+    std::ostringstream path;
+
+    path << m_config.dir << "/" << m_config.prefix << "."
+         << std::setfill('0') << std::setw(6) << m_sequence;
+    m_sequence++;
+
+    m_current = m_factory(path.str());
+    if (!m_current) {
+        throw Exception("Segment factory returned no sink");
+    }
+    m_currentPath = path.str();
+    m_currentBytes = 0;
+    m_currentOpened = std::chrono::steady_clock::now();
+}
+
+void RotatingTraceSink::rotate() {
+    m_current->flush();
+    m_current.reset();
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_pending.push_back(m_currentPath);
+    }
+    m_work.notify_all();
+
+    m_rotations++;
+    openSegment();
+}
+
+void RotatingTraceSink::write(const void *data, size_t size) {
+    bool roll = false;
+
+    if (m_config.segmentBytes && m_currentBytes &&
+        m_currentBytes + size > m_config.segmentBytes) {
+        roll = true;
+    }
+    if (m_config.segmentSeconds && m_currentBytes) {
+        auto age = std::chrono::steady_clock::now() - m_currentOpened;
+        if (age >= std::chrono::seconds(m_config.segmentSeconds)) {
+            roll = true;
+        }
+    }
+
+    if (roll) {
+        rotate();
+    }
+
+    m_current->write(data, size);
+    m_currentBytes += size;
+}
+
+void RotatingTraceSink::flush() {
+    if (m_current) {
+        m_current->flush();
+    }
+}
+
+std::string RotatingTraceSink::compressSegment(const std::string &path) {
+    std::string compressedPath = path + ".lz4";
+
+    try {
+        std::ifstream input(path, std::ios::binary);
+        if (!input.is_open()) {
+            return path;
+        }
+
+        auto file = std::make_shared<FileTraceSink>(compressedPath);
+        // Archived segments ship to the analysis cluster - frame them
+        // so damage in transit is detectable per frame
+        auto crc = std::make_shared<CrcTraceSink>(file);
+        Lz4TraceSink lz4(crc);
+
+        std::vector<char> chunk(1024 * 1024);
+        while (input.read(chunk.data(), chunk.size()) || input.gcount()) {
+            lz4.write(chunk.data(), input.gcount());
+        }
+        lz4.flush();
+    } catch (const Exception &) {
+        // Keep the raw segment on compression trouble
+        std::remove(compressedPath.c_str());
+        return path;
+    }
+
+    std::remove(path.c_str());
+
+    // Index sidecar offsets refer to the raw file - they do not survive
+    // compression of whole segments
+    std::remove((path + ".index").c_str());
+
+    return compressedPath;
+}
+
+void RotatingTraceSink::applyRetention() {
+    if (!m_config.retentionBytes) {
+        return;
+    }
+
+    while (m_finishedBytes > m_config.retentionBytes &&
+           m_finished.size() > 1) {
+        const Segment &oldest = m_finished.front();
+
+        std::remove(oldest.path.c_str());
+        std::remove((oldest.path + ".index").c_str());
+        m_finishedBytes -= oldest.size;
+        m_finished.pop_front();
+    }
+}
+
+void RotatingTraceSink::maintenanceLoop() {
+    for (;;) {
+        std::string path;
+
+        {
+            std::unique_lock<std::mutex> guard(m_lock);
+            m_work.wait(guard, [this] {
+                return m_stopping || !m_pending.empty();
+            });
+
+            if (m_pending.empty()) {
+                if (m_stopping) {
+                    break;
+                }
+                continue;
+            }
+
+            path = m_pending.front();
+            m_pending.pop_front();
+        }
+
+        if (m_config.compress) {
+            path = compressSegment(path);
+        }
+
+        Segment segment;
+        segment.path = path;
+        segment.size = fileSize(path);
+        m_finished.push_back(segment);
+        m_finishedBytes += segment.size;
+
+        applyRetention();
+    }
+}
+
+}  // namespace octf
@@ -0,0 +1,147 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_ROTATINGTRACESINK_H
+#define SOURCE_USERSPACE_ROTATINGTRACESINK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "TraceSink.h"
+
+namespace octf {
+
+/**
+ * @brief Terminal sink rolling its output across file segments
+ *
+ * Backs continuous (always-on) tracing: the output rolls to a fresh
+ * segment whenever the current one exceeds the configured size or age,
+ * closed segments are optionally LZ4 compressed and old ones pruned to
+ * a retention budget. Rotation on the write path is only a sink stack
+ * swap - compression and pruning run on a background worker, so ring
+ * draining never stalls on segment maintenance.
+ *
+ * Each segment is built by the segment factory and is a self-contained
+ * stream (e.g. v2 header per segment), so segments are independently
+ * parseable and a time range query only opens the relevant ones.
+ */
+class RotatingTraceSink : public ITraceSink {
+public:
+    /**
+     * @brief Builds the sink stack of one segment
+     *
+     * @param path Segment file path
+     */
+    typedef std::function<std::shared_ptr<ITraceSink>(const std::string &path)>
+            SegmentFactory;
+
+    /**
+     * @brief Continuous mode settings
+     */
+    struct Config {
+        /** Directory receiving the segments */
+        std::string dir;
+
+        /** Segment file name prefix */
+        std::string prefix = "iotrace";
+
+        /** Roll after this many bytes (0 - no size trigger) */
+        uint64_t segmentBytes = 256ULL * 1024ULL * 1024ULL;
+
+        /** Roll after this many seconds (0 - no time trigger) */
+        uint64_t segmentSeconds = 0;
+
+        /** Prune oldest segments above this total (0 - keep all) */
+        uint64_t retentionBytes = 0;
+
+        /** Compress closed segments in the background */
+        bool compress = false;
+    };
+
+    /**
+     * @param config Continuous mode settings
+     * @param factory Per-segment sink stack builder
+     */
+    RotatingTraceSink(const Config &config, SegmentFactory factory);
+    virtual ~RotatingTraceSink();
+
+    void write(const void *data, size_t size) override;
+
+    void flush() override;
+
+    /**
+     * @brief Gets number of completed rotations
+     */
+    uint64_t getRotations() const {
+        return m_rotations;
+    }
+
+private:
+    /**
+     * @brief Opens the next segment
+     */
+    void openSegment();
+
+    /**
+     * @brief Hands the current segment over to the background worker
+     */
+    void rotate();
+
+    /**
+     * @brief Background worker compressing and pruning segments
+     */
+    void maintenanceLoop();
+
+    /**
+     * @brief Compresses one closed segment in place (path -> path.lz4)
+     *
+     * @param path Segment path
+     *
+     * @return Path of the resulting file
+     */
+    std::string compressSegment(const std::string &path);
+
+    /**
+     * @brief Prunes oldest finished segments over the retention budget
+     */
+    void applyRetention();
+
+    Config m_config;
+    SegmentFactory m_factory;
+
+    /** Sink stack of the open segment */
+    std::shared_ptr<ITraceSink> m_current;
+    std::string m_currentPath;
+    uint64_t m_currentBytes;
+    std::chrono::steady_clock::time_point m_currentOpened;
+
+    /** Monotonic segment numbering */
+    uint64_t m_sequence;
+    uint64_t m_rotations;
+
+    /** Finished segment bookkeeping (worker owned) */
+    struct Segment {
+        std::string path;
+        uint64_t size;
+    };
+    std::deque<Segment> m_finished;
+    uint64_t m_finishedBytes;
+
+    /** Closed segments awaiting maintenance */
+    std::deque<std::string> m_pending;
+    std::mutex m_lock;
+    std::condition_variable m_work;
+    bool m_stopping;
+    std::thread m_worker;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_ROTATINGTRACESINK_H
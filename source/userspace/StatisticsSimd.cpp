@@ -0,0 +1,61 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "StatisticsSimd.h"
+
+namespace octf {
+
+/**
+ * @brief log2 bucket of a value, bucket 0 covers 0 and 1
+ */
+static unsigned log2Bucket(uint64_t value) {
+    unsigned bucket = 0;
+
+    while (value > 1) {
+        value >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void aggregateIoEventsScalar(const struct iotrace_event *events,
+                             size_t count,
+                             IoEventAggregate &aggregate) {
+    for (size_t i = 0; i < count; i++) {
+        const struct iotrace_event *event = &events[i];
+
+        switch (event->operation) {
+        case iotrace_event_operation_rd:
+            aggregate.count[IoEventAggregate::OP_READ]++;
+            aggregate.sectors[IoEventAggregate::OP_READ] += event->len;
+            break;
+        case iotrace_event_operation_wr:
+            aggregate.count[IoEventAggregate::OP_WRITE]++;
+            aggregate.sectors[IoEventAggregate::OP_WRITE] += event->len;
+            break;
+        case iotrace_event_operation_discard:
+            aggregate.count[IoEventAggregate::OP_DISCARD]++;
+            aggregate.sectors[IoEventAggregate::OP_DISCARD] += event->len;
+            break;
+        default:
+            break;
+        }
+
+        aggregate.ioClasses[event->io_class]++;
+        aggregate.sizeHistogram[log2Bucket(event->len)]++;
+    }
+}
+
+IoAggregateFn getIoAggregateKernel() {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+        return aggregateIoEventsAvx2;
+    }
+#endif
+    return aggregateIoEventsScalar;
+}
+
+}  // namespace octf
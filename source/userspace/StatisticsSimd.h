@@ -0,0 +1,77 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_STATISTICSSIMD_H
+#define SOURCE_USERSPACE_STATISTICSSIMD_H
+
+#include <octf/trace/iotrace_event.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace octf {
+
+/**
+ * @brief Flat aggregate of one run of IO events
+ *
+ * Deliberately map-free: plain arrays indexed by operation, log2 bucket
+ * and io class, so the aggregation kernels touch no pointer-chasing
+ * containers. The collector folds it into its DeviceStatistics maps
+ * once per run instead of once per event.
+ */
+struct IoEventAggregate {
+    enum Op { OP_READ = 0, OP_WRITE, OP_DISCARD, OP_MAX };
+
+    uint64_t count[OP_MAX] = {};
+    uint64_t sectors[OP_MAX] = {};
+
+    /** log2(request sectors) histogram, matches DeviceStatistics */
+    uint64_t sizeHistogram[32] = {};
+
+    /** Requests per DSS io class */
+    uint64_t ioClasses[256] = {};
+};
+
+/**
+ * @brief Aggregation kernel over a contiguous run of fixed-width events
+ *
+ * @param events First event of the run; all count events are full
+ *        iotrace_event records of one device
+ * @param count Number of events in the run
+ * @param aggregate Aggregate accumulated into
+ */
+typedef void (*IoAggregateFn)(const struct iotrace_event *events,
+                              size_t count,
+                              IoEventAggregate &aggregate);
+
+/**
+ * @brief Portable aggregation kernel
+ */
+void aggregateIoEventsScalar(const struct iotrace_event *events,
+                             size_t count,
+                             IoEventAggregate &aggregate);
+
+/**
+ * @brief AVX2 aggregation kernel, 8 events per iteration
+ *
+ * Built in its own translation unit with -mavx2; falls through to the
+ * scalar kernel when the target does not provide AVX2 at compile time.
+ * Callers go through getIoAggregateKernel() - never call this without a
+ * runtime AVX2 check.
+ */
+void aggregateIoEventsAvx2(const struct iotrace_event *events,
+                           size_t count,
+                           IoEventAggregate &aggregate);
+
+/**
+ * @brief Picks the fastest aggregation kernel for this machine
+ *
+ * Runtime dispatch - the binary runs on any x86_64, AVX2 machines get
+ * the vectorized path. Resolve once and cache the pointer.
+ */
+IoAggregateFn getIoAggregateKernel();
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_STATISTICSSIMD_H
@@ -0,0 +1,109 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * AVX2 aggregation kernel. This translation unit is built with -mavx2;
+ * nothing here may be called without a runtime AVX2 check - that is
+ * what getIoAggregateKernel() is for.
+ */
+
+#include "StatisticsSimd.h"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+#include <cstddef>
+
+namespace octf {
+
+/** Events per vector iteration */
+#define AVX2_LANES 8
+
+void aggregateIoEventsAvx2(const struct iotrace_event *events,
+                           size_t count,
+                           IoEventAggregate &aggregate) {
+    static_assert(sizeof(struct iotrace_event) % 4 == 0,
+                  "event stride has to be dword granular for gathers");
+    static_assert(offsetof(struct iotrace_event, len) % 4 == 0,
+                  "len has to be dword aligned for gathers");
+
+    const int *base = reinterpret_cast<const int *>(events);
+    const int stride = sizeof(struct iotrace_event) / 4;
+    const int lenOff = offsetof(struct iotrace_event, len) / 4;
+
+    // Lane j reads event i + j
+    __m256i laneIndex = _mm256_mullo_epi32(
+            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+            _mm256_set1_epi32(stride));
+
+    size_t i = 0;
+    for (; i + AVX2_LANES <= count; i += AVX2_LANES) {
+        __m256i index = _mm256_add_epi32(
+                laneIndex,
+                _mm256_set1_epi32(static_cast<int>(i) * stride + lenOff));
+        __m256i len = _mm256_i32gather_epi32(base, index, 4);
+
+        // log2 bucket via the float exponent; requests are way below
+        // 2^24 sectors so the conversion is exact
+        __m256 lenFloat = _mm256_cvtepi32_ps(len);
+        __m256i bucket = _mm256_sub_epi32(
+                _mm256_srli_epi32(_mm256_castps_si256(lenFloat), 23),
+                _mm256_set1_epi32(127));
+        // len 0 and 1 both land in bucket 0
+        bucket = _mm256_max_epi32(bucket, _mm256_setzero_si256());
+
+        uint32_t buckets[AVX2_LANES];
+        uint32_t lens[AVX2_LANES];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(buckets), bucket);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lens), len);
+
+        // Histogram and per-op increments scatter into shared slots, so
+        // they stay scalar (conflict-free scatter needs AVX-512CD); the
+        // bucket math above and the streaming gathers are the win
+        for (unsigned lane = 0; lane < AVX2_LANES; lane++) {
+            const struct iotrace_event *event = &events[i + lane];
+
+            switch (event->operation) {
+            case iotrace_event_operation_rd:
+                aggregate.count[IoEventAggregate::OP_READ]++;
+                aggregate.sectors[IoEventAggregate::OP_READ] += lens[lane];
+                break;
+            case iotrace_event_operation_wr:
+                aggregate.count[IoEventAggregate::OP_WRITE]++;
+                aggregate.sectors[IoEventAggregate::OP_WRITE] += lens[lane];
+                break;
+            case iotrace_event_operation_discard:
+                aggregate.count[IoEventAggregate::OP_DISCARD]++;
+                aggregate.sectors[IoEventAggregate::OP_DISCARD] +=
+                        lens[lane];
+                break;
+            default:
+                break;
+            }
+
+            aggregate.ioClasses[event->io_class]++;
+            aggregate.sizeHistogram[buckets[lane]]++;
+        }
+    }
+
+    aggregateIoEventsScalar(events + i, count - i, aggregate);
+}
+
+}  // namespace octf
+
+#else
+
+namespace octf {
+
+void aggregateIoEventsAvx2(const struct iotrace_event *events,
+                           size_t count,
+                           IoEventAggregate &aggregate) {
+    // Toolchain without AVX2 - keep the symbol, fall through
+    aggregateIoEventsScalar(events, count, aggregate);
+}
+
+}  // namespace octf
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "TcpTraceSink.h"
+#include <netdb.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <octf/utils/Exception.h>
+#include <cstring>
+
+namespace octf {
+
+TcpTraceSink::TcpTraceSink(const std::string &host,
+                           uint16_t port,
+                           uint64_t bufferLimit)
+        : m_socket(-1)
+        , m_bufferLimit(bufferLimit)
+        , m_queue()
+        , m_queuedBytes(0)
+        , m_lock()
+        , m_pushed()
+        , m_drained()
+        , m_stopping(false)
+        , m_broken(false)
+        , m_sender()
+        , m_sentBytes(0)
+        , m_droppedFrames(0)
+        , m_droppedBytes(0) {
+    struct addrinfo hints = {};
+    struct addrinfo *result = NULL;
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    std::string service = std::to_string(port);
+    int error = getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+    if (error) {
+        throw Exception("Cannot resolve trace collector " + host + ": " +
+                        gai_strerror(error));
+    }
+
+    for (struct addrinfo *addr = result; addr; addr = addr->ai_next) {
+        m_socket = ::socket(addr->ai_family, addr->ai_socktype,
+                            addr->ai_protocol);
+        if (m_socket < 0) {
+            continue;
+        }
+        if (!::connect(m_socket, addr->ai_addr, addr->ai_addrlen)) {
+            break;
+        }
+        ::close(m_socket);
+        m_socket = -1;
+    }
+    freeaddrinfo(result);
+
+    if (m_socket < 0) {
+        throw Exception("Cannot connect to trace collector " + host + ":" +
+                        service);
+    }
+
+    m_sender = std::thread(&TcpTraceSink::senderLoop, this);
+}
+
+TcpTraceSink::~TcpTraceSink() {
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopping = true;
+    }
+    m_pushed.notify_all();
+
+    if (m_sender.joinable()) {
+        m_sender.join();
+    }
+
+    if (m_socket >= 0) {
+        ::close(m_socket);
+    }
+}
+
+void TcpTraceSink::write(const void *data, size_t size) {
+    std::vector<char> frame(sizeof(TcpFrameHeader) + size);
+    TcpFrameHeader *header = reinterpret_cast<TcpFrameHeader *>(frame.data());
+
+    header->magic = TCP_FRAME_MAGIC;
+    header->size = size;
+    std::memcpy(frame.data() + sizeof(*header), data, size);
+
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if (m_broken || m_queuedBytes + frame.size() > m_bufferLimit) {
+        // Never block the drain path on the network - account and move on
+        m_droppedFrames++;
+        m_droppedBytes += size;
+        return;
+    }
+
+    m_queuedBytes += frame.size();
+    m_queue.push_back(std::move(frame));
+    m_pushed.notify_one();
+}
+
+void TcpTraceSink::flush() {
+    std::unique_lock<std::mutex> guard(m_lock);
+
+    m_drained.wait(guard,
+                   [this] { return m_queue.empty() || m_broken; });
+}
+
+void TcpTraceSink::senderLoop() {
+    for (;;) {
+        std::vector<char> frame;
+
+        {
+            std::unique_lock<std::mutex> guard(m_lock);
+            m_pushed.wait(guard, [this] {
+                return m_stopping || !m_queue.empty();
+            });
+
+            if (m_queue.empty()) {
+                break;
+            }
+
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_queuedBytes -= frame.size();
+        }
+
+        size_t done = 0;
+        bool failed = false;
+
+        while (done < frame.size()) {
+            ssize_t sent = ::send(m_socket, frame.data() + done,
+                                  frame.size() - done, MSG_NOSIGNAL);
+            if (sent <= 0) {
+                failed = true;
+                break;
+            }
+            done += sent;
+            m_sentBytes += sent;
+        }
+
+        if (failed) {
+            std::lock_guard<std::mutex> guard(m_lock);
+
+            // Count everything still queued as lost and stop sending
+            m_broken = true;
+            m_droppedFrames += 1 + m_queue.size();
+            m_droppedBytes += frame.size() - done;
+            for (const auto &pending : m_queue) {
+                m_droppedBytes += pending.size() - sizeof(TcpFrameHeader);
+            }
+            m_queue.clear();
+            m_queuedBytes = 0;
+            m_drained.notify_all();
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (m_queue.empty()) {
+                m_drained.notify_all();
+            }
+        }
+    }
+
+    m_drained.notify_all();
+}
+
+}  // namespace octf
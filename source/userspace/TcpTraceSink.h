@@ -0,0 +1,122 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_TCPTRACESINK_H
+#define SOURCE_USERSPACE_TCPTRACESINK_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TraceSink.h"
+
+namespace octf {
+
+/**
+ * @brief Header of one framed batch on the wire
+ */
+struct TcpFrameHeader {
+    /** Frame marker, TCP_FRAME_MAGIC */
+    uint32_t magic;
+
+    /** Size of the payload following this header */
+    uint32_t size;
+} __attribute__((packed));
+
+/**
+ * @brief Sink streaming drained batches to a remote collector
+ *
+ * For hosts where local trace files would perturb the traced devices
+ * themselves. Batches are framed and queued into a bounded send buffer
+ * serviced by a sender thread; when the collector cannot keep up the
+ * sink drops whole frames and accounts for them instead of blocking
+ * the drain path. A broken connection turns the sink into a counting
+ * null sink - tracing continues, the loss is reported.
+ */
+class TcpTraceSink : public ITraceSink {
+public:
+    /** Frame marker value ("TNET") */
+    static const uint32_t TCP_FRAME_MAGIC = 0x54454E54;
+
+    /** Default bound of the send buffer */
+    static const uint64_t DEFAULT_BUFFER_LIMIT = 64ULL * 1024ULL * 1024ULL;
+
+    /**
+     * @param host Collector host name or address
+     * @param port Collector TCP port
+     * @param bufferLimit Send buffer bound in bytes
+     */
+    TcpTraceSink(const std::string &host,
+                 uint16_t port,
+                 uint64_t bufferLimit = DEFAULT_BUFFER_LIMIT);
+    virtual ~TcpTraceSink();
+
+    void write(const void *data, size_t size) override;
+
+    /**
+     * @brief Waits until the send buffer is drained (or the connection
+     *        is gone)
+     */
+    void flush() override;
+
+    /**
+     * @brief Gets number of bytes handed to the socket
+     */
+    uint64_t getSentBytes() const {
+        return m_sentBytes;
+    }
+
+    /**
+     * @brief Gets number of frames dropped under backpressure or after
+     *        a connection failure
+     */
+    uint64_t getDroppedFrames() const {
+        return m_droppedFrames;
+    }
+
+    /**
+     * @brief Gets number of payload bytes dropped
+     */
+    uint64_t getDroppedBytes() const {
+        return m_droppedBytes;
+    }
+
+    /**
+     * @brief Checks whether the connection is still alive
+     */
+    bool isConnected() const {
+        return !m_broken;
+    }
+
+private:
+    /**
+     * @brief Sender thread body
+     */
+    void senderLoop();
+
+    int m_socket;
+    uint64_t m_bufferLimit;
+
+    /** Queued frames and their total size */
+    std::deque<std::vector<char>> m_queue;
+    uint64_t m_queuedBytes;
+
+    std::mutex m_lock;
+    std::condition_variable m_pushed;
+    std::condition_variable m_drained;
+    bool m_stopping;
+    bool m_broken;
+    std::thread m_sender;
+
+    uint64_t m_sentBytes;
+    uint64_t m_droppedFrames;
+    uint64_t m_droppedBytes;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_TCPTRACESINK_H
@@ -0,0 +1,247 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "TraceDrainPipeline.h"
+#include <pthread.h>
+#include <octf/utils/Exception.h>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+
+namespace octf {
+
+TraceDrainPipeline::TraceDrainPipeline(uint32_t queueCount,
+                                       uint32_t circBufferSizeMiB,
+                                       std::shared_ptr<ITraceSink> sink)
+        : m_queueCount(queueCount)
+        , m_circBufferSizeMiB(circBufferSizeMiB)
+        , m_sink(sink)
+        , m_topology()
+        , m_shardFactory()
+        , m_nodeSinks()
+        , m_nodeLocks()
+        , m_producers()
+        , m_threads()
+        , m_sinkLock()
+        , m_running(false)
+        , m_counters(new QueueCounters[queueCount])
+        , m_workerError()
+        , m_errorLock() {
+    if (!m_queueCount) {
+        throw Exception("Trace drain pipeline needs at least one queue");
+    }
+}
+
+uint64_t TraceDrainPipeline::getDrainedEvents() const {
+    uint64_t total = 0;
+
+    for (uint32_t queue = 0; queue < m_queueCount; queue++) {
+        total += m_counters[queue].events.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t TraceDrainPipeline::getDrainedBytes() const {
+    uint64_t total = 0;
+
+    for (uint32_t queue = 0; queue < m_queueCount; queue++) {
+        total += m_counters[queue].bytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+TraceDrainPipeline::TraceDrainPipeline(uint32_t queueCount,
+                                       uint32_t circBufferSizeMiB,
+                                       SinkShardFactory factory)
+        : TraceDrainPipeline(queueCount, circBufferSizeMiB,
+                             std::shared_ptr<ITraceSink>()) {
+    if (!factory) {
+        throw Exception("No sink shard factory provided");
+    }
+    m_shardFactory = factory;
+}
+
+TraceDrainPipeline::~TraceDrainPipeline() {
+    try {
+        stop();
+    } catch (...) {
+        // The capture loop calls stop() itself and gets the error
+        // there; stopping from the destructor has no caller to tell
+    }
+}
+
+void TraceDrainPipeline::start() {
+    if (m_running) {
+        return;
+    }
+
+    // Kernel splits the total buffer evenly across rings
+    uint64_t poolSize =
+            m_circBufferSizeMiB * 1024ULL * 1024ULL / m_queueCount;
+
+    m_producers.resize(m_queueCount);
+    for (uint32_t queue = 0; queue < m_queueCount; queue++) {
+        m_producers[queue] = std::unique_ptr<KernelRingTraceProducer>(
+                new KernelRingTraceProducer(queue));
+        m_producers[queue]->initRing(poolSize);
+    }
+
+    if (m_shardFactory) {
+        // Instantiate one shard per node which owns at least one ring
+        m_nodeSinks.resize(m_topology.getNodeCount());
+        m_nodeLocks.resize(m_topology.getNodeCount());
+        for (uint32_t queue = 0; queue < m_queueCount; queue++) {
+            uint32_t node = m_topology.getNodeOfCpu(queue);
+            if (!m_nodeSinks[node]) {
+                m_nodeSinks[node] = m_shardFactory(node);
+                m_nodeLocks[node] =
+                        std::unique_ptr<std::mutex>(new std::mutex());
+            }
+        }
+    }
+
+    m_running = true;
+    for (uint32_t queue = 0; queue < m_queueCount; queue++) {
+        m_threads.emplace_back(&TraceDrainPipeline::drainLoop, this, queue);
+    }
+}
+
+void TraceDrainPipeline::stop() {
+    if (m_threads.empty()) {
+        return;
+    }
+
+    m_running = false;
+    for (auto &producer : m_producers) {
+        producer->stop();
+    }
+
+    for (auto &thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    m_threads.clear();
+    m_producers.clear();
+
+    // A failed sink stack is not flushed - the flush would throw the
+    // same error again and mask the one stored first
+    if (!m_workerError) {
+        if (m_sink) {
+            m_sink->flush();
+        }
+
+        for (auto &sink : m_nodeSinks) {
+            if (sink) {
+                sink->flush();
+            }
+        }
+    }
+
+    if (m_workerError) {
+        std::exception_ptr error = m_workerError;
+        m_workerError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void TraceDrainPipeline::consumeBatch(uint32_t queue,
+                                      const void *data,
+                                      size_t size) {
+    if (!m_nodeSinks.empty()) {
+        uint32_t node = m_topology.getNodeOfCpu(queue);
+
+        std::lock_guard<std::mutex> guard(*m_nodeLocks[node]);
+        m_nodeSinks[node]->write(data, size);
+        return;
+    }
+
+    if (m_sink) {
+        std::lock_guard<std::mutex> guard(m_sinkLock);
+        m_sink->write(data, size);
+    }
+}
+
+void TraceDrainPipeline::pinToNodeOfQueue(uint32_t queue) {
+    cpu_set_t cpuSet;
+
+    // Rings are per-CPU and numbered by CPU id
+    if (m_topology.getNodeCpuSet(m_topology.getNodeOfCpu(queue), cpuSet)) {
+        // Best effort - an unpinned consumer still drains correctly
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    }
+}
+
+void TraceDrainPipeline::drainLoop(uint32_t queue) {
+    KernelRingTraceProducer &producer = *m_producers[queue];
+    QueueCounters &counters = m_counters[queue];
+
+    pinToNodeOfQueue(queue);
+    TraceEventBatch batch;
+    std::vector<char> staging;
+
+    try {
+        for (;;) {
+            uint32_t count = producer.drainBatch(batch);
+
+            if (!count) {
+                // Ring is empty - leave once stopped, otherwise park
+                // until the kernel signals new events (checked at least
+                // every 0.5s)
+                if (!m_running) {
+                    break;
+                }
+                auto deadline = std::chrono::steady_clock::now() +
+                                std::chrono::milliseconds(500);
+                producer.wait(deadline);
+                continue;
+            }
+
+            // Pack the claimed events contiguously; claimed spans may
+            // wrap around the ring end so a batch is not guaranteed
+            // contiguous
+            staging.clear();
+            for (uint32_t i = 0; i < count; i++) {
+                const char *event =
+                        static_cast<const char *>(batch.events[i]);
+                staging.insert(staging.end(), event, event + batch.sizes[i]);
+            }
+
+            consumeBatch(queue, staging.data(), staging.size());
+
+            producer.releaseBatch(batch);
+
+            // Single writer per slot - a plain relaxed store suffices
+            counters.events.store(
+                    counters.events.load(std::memory_order_relaxed) + count,
+                    std::memory_order_relaxed);
+            counters.bytes.store(
+                    counters.bytes.load(std::memory_order_relaxed) +
+                            staging.size(),
+                    std::memory_order_relaxed);
+        }
+    } catch (...) {
+        // A throwing sink (disk full, lost connection) must end the
+        // capture with an error, not escape the thread and abort the
+        // process; stop() rethrows what is stored here
+        {
+            std::lock_guard<std::mutex> guard(m_errorLock);
+            if (!m_workerError) {
+                m_workerError = std::current_exception();
+            }
+        }
+
+        m_running = false;
+        for (auto &other : m_producers) {
+            other->stop();
+        }
+
+        // End the capture wait the way the executor does when tracing
+        // finishes; all pipeline capture modes register this signal
+        raise(SIGUSR1);
+    }
+}
+
+}  // namespace octf
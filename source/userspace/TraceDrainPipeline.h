@@ -0,0 +1,165 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_TRACEDRAINPIPELINE_H
+#define SOURCE_USERSPACE_TRACEDRAINPIPELINE_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "KernelRingTraceProducer.h"
+#include "NumaTopology.h"
+#include "TraceSink.h"
+
+namespace octf {
+
+/**
+ * @brief Drains the per-CPU kernel rings into a trace sink
+ *
+ * One consumer thread per ring claims events in batches (zero-copy via
+ * KernelRingTraceProducer::drainBatch), packs each batch contiguously
+ * and hands it to the configured sink. Sinks may be stacked, e.g. file
+ * output behind an LZ4 compression stage.
+ *
+ * This pipeline backs the capture modes which do not go through the
+ * framework's file serializer.
+ */
+class TraceDrainPipeline {
+public:
+    /**
+     * @param queueCount Number of trace queues (rings) to drain
+     * @param circBufferSizeMiB Total size of kernel trace buffers in MiB
+     * @param sink Destination of drained batches
+     */
+    TraceDrainPipeline(uint32_t queueCount,
+                       uint32_t circBufferSizeMiB,
+                       std::shared_ptr<ITraceSink> sink);
+
+    /**
+     * @brief Factory creating one sink shard per NUMA node
+     *
+     * @param node NUMA node the shard serves
+     */
+    typedef std::function<std::shared_ptr<ITraceSink>(uint32_t node)>
+            SinkShardFactory;
+
+    /**
+     * @brief Constructs a NUMA sharded pipeline
+     *
+     * Consumer threads are pinned to the node owning their ring and
+     * drain into a per-node sink shard, so neither the ring reads nor
+     * the sink writes cross the interconnect. Shards form one logical
+     * trace and are merged on the read side.
+     *
+     * @param queueCount Number of trace queues (rings) to drain
+     * @param circBufferSizeMiB Total size of kernel trace buffers in MiB
+     * @param factory Called once per node owning at least one ring
+     */
+    TraceDrainPipeline(uint32_t queueCount,
+                       uint32_t circBufferSizeMiB,
+                       SinkShardFactory factory);
+
+    virtual ~TraceDrainPipeline();
+
+    /**
+     * @brief Maps rings and starts the consumer threads
+     */
+    void start();
+
+    /**
+     * @brief Stops consumers, drains ring remainders and flushes the sink
+     *
+     * Rethrows the first error a consumer thread hit, so a capture
+     * failing mid-drain (e.g. sink disk full) ends with an error
+     * instead of aborting the process.
+     */
+    void stop();
+
+    /**
+     * @brief Gets number of events drained so far
+     */
+    uint64_t getDrainedEvents() const;
+
+    /**
+     * @brief Gets number of bytes drained so far (before sink stages)
+     */
+    uint64_t getDrainedBytes() const;
+
+protected:
+    /**
+     * @brief Consumes one packed batch
+     *
+     * Default implementation forwards the batch to the sink; capture
+     * modes which aggregate instead of storing override this.
+     *
+     * @param queue Queue (ring) the batch was drained from
+     * @param data Packed batch payload
+     * @param size Payload size in bytes
+     */
+    virtual void consumeBatch(uint32_t queue, const void *data, size_t size);
+
+private:
+    /**
+     * @brief Consumer thread body draining one ring
+     */
+    void drainLoop(uint32_t queue);
+
+    /**
+     * @brief Pins the calling consumer thread to the node of its ring
+     */
+    void pinToNodeOfQueue(uint32_t queue);
+
+    uint32_t m_queueCount;
+    uint32_t m_circBufferSizeMiB;
+    std::shared_ptr<ITraceSink> m_sink;
+
+    /** CPU to node map; shards and thread affinity derive from it */
+    NumaTopology m_topology;
+
+    /** Per-node shard factory; empty in single sink operation */
+    SinkShardFactory m_shardFactory;
+
+    /** Node id indexed sink shards (unused entries stay empty) */
+    std::vector<std::shared_ptr<ITraceSink>> m_nodeSinks;
+
+    /** One lock per shard so nodes do not serialize against each other */
+    std::vector<std::unique_ptr<std::mutex>> m_nodeLocks;
+
+    std::vector<std::unique_ptr<KernelRingTraceProducer>> m_producers;
+    std::vector<std::thread> m_threads;
+
+    /** Serializes sink access across consumer threads */
+    std::mutex m_sinkLock;
+
+    std::atomic<bool> m_running;
+
+    /**
+     * @brief Drain counters of one consumer thread
+     *
+     * Padded to a cache line of its own so consumers never bounce a
+     * line between cores; each slot has a single writer and relaxed
+     * readers (the getters and the progress reporter), so the hot path
+     * is a plain store - no locks, no read-modify-write.
+     */
+    struct alignas(64) QueueCounters {
+        std::atomic<uint64_t> events;
+        std::atomic<uint64_t> bytes;
+
+        QueueCounters() : events(0), bytes(0) {}
+    };
+
+    std::unique_ptr<QueueCounters[]> m_counters;
+
+    /** First error thrown by a consumer thread, rethrown from stop() */
+    std::exception_ptr m_workerError;
+    std::mutex m_errorLock;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_TRACEDRAINPIPELINE_H
@@ -0,0 +1,226 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "TraceFormatV2.h"
+#include <octf/utils/Exception.h>
+#include <cstdint>
+#include <cstring>
+
+namespace octf {
+
+void TraceFormatV2::putVarint(std::vector<char> &buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+bool TraceFormatV2::getVarint(const char *&data,
+                              const char *end,
+                              uint64_t &value) {
+    uint64_t result = 0;
+    int shift = 0;
+
+    while (data < end && shift < 64) {
+        uint8_t byte = static_cast<uint8_t>(*data++);
+        result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            value = result;
+            return true;
+        }
+        shift += 7;
+    }
+
+    return false;
+}
+
+void TraceFormatV2::encodeBatch(const void *data,
+                                size_t size,
+                                std::vector<char> &output) {
+    const char *ptr = static_cast<const char *>(data);
+    const char *end = ptr + size;
+
+    output.clear();
+
+    // Count events first - every event starts with the fixed header
+    uint64_t count = 0;
+    const char *walk = ptr;
+    while (walk + sizeof(struct iotrace_event_hdr) <= end) {
+        const struct iotrace_event_hdr *hdr =
+                reinterpret_cast<const struct iotrace_event_hdr *>(walk);
+        if (hdr->size < sizeof(*hdr) || walk + hdr->size > end) {
+            throw Exception("Malformed event in trace batch");
+        }
+        walk += hdr->size;
+        count++;
+    }
+    if (walk != end) {
+        // Trailing fragment shorter than a header - the encode loop
+        // below must never dereference it
+        throw Exception("Malformed event in trace batch");
+    }
+    putVarint(output, count);
+
+    // Deltas start against zero, so the first event encodes its
+    // absolute values without a special case
+    uint64_t prevSid = 0;
+    uint64_t prevTimestamp = 0;
+    uint64_t prevLba = 0;
+
+    while (ptr < end) {
+        const struct iotrace_event_hdr *hdr =
+                reinterpret_cast<const struct iotrace_event_hdr *>(ptr);
+
+        if (hdr->type == iotrace_event_type_io &&
+            hdr->size == sizeof(struct iotrace_event)) {
+            const struct iotrace_event *event =
+                    reinterpret_cast<const struct iotrace_event *>(ptr);
+
+            output.push_back(TAG_IO);
+            putVarint(output, zigzag(hdr->sid - prevSid));
+            putVarint(output, zigzag(hdr->timestamp - prevTimestamp));
+            putVarint(output, zigzag(event->lba - prevLba));
+            putVarint(output, event->len);
+            putVarint(output, event->dev_id);
+            output.push_back(static_cast<char>(event->io_class));
+            output.push_back(static_cast<char>(event->operation));
+            output.push_back(static_cast<char>(event->flags));
+
+            prevSid = hdr->sid;
+            prevTimestamp = hdr->timestamp;
+            prevLba = event->lba;
+        } else {
+            // Unknown or non-IO event - pass through raw
+            output.push_back(TAG_RAW);
+            putVarint(output, hdr->size);
+            output.insert(output.end(), ptr, ptr + hdr->size);
+        }
+
+        ptr += hdr->size;
+    }
+}
+
+void TraceFormatV2::decodeBatch(const void *data,
+                                size_t size,
+                                std::vector<char> &output) {
+    const char *ptr = static_cast<const char *>(data);
+    const char *end = ptr + size;
+    uint64_t count;
+
+    output.clear();
+
+    if (!getVarint(ptr, end, count)) {
+        throw Exception("Truncated v2 trace batch");
+    }
+
+    uint64_t prevSid = 0;
+    uint64_t prevTimestamp = 0;
+    uint64_t prevLba = 0;
+
+    for (uint64_t i = 0; i < count; i++) {
+        if (ptr >= end) {
+            throw Exception("Truncated v2 trace batch");
+        }
+
+        uint8_t tag = static_cast<uint8_t>(*ptr++);
+
+        if (tag == TAG_IO) {
+            uint64_t sidDelta, timestampDelta, lbaDelta, len, devId;
+
+            if (!getVarint(ptr, end, sidDelta) ||
+                !getVarint(ptr, end, timestampDelta) ||
+                !getVarint(ptr, end, lbaDelta) ||
+                !getVarint(ptr, end, len) || !getVarint(ptr, end, devId) ||
+                end - ptr < 3) {
+                throw Exception("Truncated v2 trace batch");
+            }
+
+            if (len > UINT32_MAX || devId > UINT32_MAX) {
+                // Both fields are 32-bit in the event; a wider varint
+                // only occurs in a damaged batch and must not be
+                // truncated into a plausible value
+                throw Exception("Corrupted field in v2 trace batch");
+            }
+
+            struct iotrace_event event = {};
+
+            prevSid += unzigzag(sidDelta);
+            prevTimestamp += unzigzag(timestampDelta);
+            prevLba += unzigzag(lbaDelta);
+
+            iotrace_event_init_hdr(&event.hdr, iotrace_event_type_io,
+                                   prevSid, prevTimestamp, sizeof(event));
+            event.lba = prevLba;
+            event.len = len;
+            event.dev_id = devId;
+            event.io_class = static_cast<uint8_t>(*ptr++);
+            event.operation = static_cast<uint8_t>(*ptr++);
+            event.flags = static_cast<uint8_t>(*ptr++);
+
+            const char *raw = reinterpret_cast<const char *>(&event);
+            output.insert(output.end(), raw, raw + sizeof(event));
+        } else if (tag == TAG_RAW) {
+            uint64_t rawSize;
+
+            if (!getVarint(ptr, end, rawSize) ||
+                rawSize < sizeof(struct iotrace_event_hdr) ||
+                static_cast<uint64_t>(end - ptr) < rawSize) {
+                throw Exception("Truncated v2 trace batch");
+            }
+
+            output.insert(output.end(), ptr, ptr + rawSize);
+            ptr += rawSize;
+        } else {
+            throw Exception("Unknown v2 trace event tag");
+        }
+    }
+}
+
+V2EncodingSink::V2EncodingSink(std::shared_ptr<ITraceSink> sink)
+        : m_sink(sink)
+        , m_encoded()
+        , m_headerWritten(false)
+        , m_clockInfoProvider() {
+    if (!m_sink) {
+        throw Exception("No sink provided for v2 encoding stage");
+    }
+}
+
+void V2EncodingSink::setClockInfoProvider(ClockInfoProvider provider) {
+    m_clockInfoProvider = provider;
+}
+
+void V2EncodingSink::write(const void *data, size_t size) {
+    if (!m_headerWritten) {
+        TraceFormatV2::FileHeader header;
+        header.magic = TraceFormatV2::FILE_MAGIC;
+        header.versionMajor = TraceFormatV2::VERSION_MAJOR;
+        header.versionMinor = TraceFormatV2::VERSION_MINOR;
+        header.clockSource = TraceFormatV2::CLOCK_KTIME;
+        header.clockRaw = 0;
+        header.clockReal = 0;
+        if (m_clockInfoProvider) {
+            m_clockInfoProvider(header.clockSource, header.clockRaw,
+                                header.clockReal);
+        }
+        m_sink->write(&header, sizeof(header));
+        m_headerWritten = true;
+    }
+
+    TraceFormatV2::encodeBatch(data, size, m_encoded);
+
+    // Length-prefix the encoded batch so a reader can iterate batches
+    std::vector<char> prefix;
+    TraceFormatV2::putVarint(prefix, m_encoded.size());
+    m_sink->write(prefix.data(), prefix.size());
+    m_sink->write(m_encoded.data(), m_encoded.size());
+}
+
+void V2EncodingSink::flush() {
+    m_sink->flush();
+}
+
+}  // namespace octf
@@ -0,0 +1,192 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_TRACEFORMATV2_H
+#define SOURCE_USERSPACE_TRACEFORMATV2_H
+
+#include <octf/trace/iotrace_event.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "TraceSink.h"
+
+namespace octf {
+
+/**
+ * @brief Compact serialized trace format (v2)
+ *
+ * The in-kernel event format stays fixed-width for push speed; this
+ * encoding is applied at serialization time. Each drained batch is
+ * encoded independently: the first event carries absolute values, the
+ * following ones varint deltas of sid, timestamp and lba against their
+ * predecessor. Consecutive events of one CPU stream differ by tiny
+ * deltas, so most fields shrink to one byte. Event types the encoder
+ * does not know are passed through raw, which keeps the format forward
+ * compatible with new kernel-side event types.
+ *
+ * A v2 stream starts with a FileHeader; the kernel module handshake
+ * (magic/major/minor via procfs) is unaffected.
+ */
+class TraceFormatV2 {
+public:
+    /** v2 stream marker ("IOT2") */
+    static const uint32_t FILE_MAGIC = 0x32544F49;
+
+    /** Format version of this writer */
+    static const uint16_t VERSION_MAJOR = 2;
+    static const uint16_t VERSION_MINOR = 1;
+
+    /** Timestamp sources a capture may use (mirrors the kernel knob) */
+    enum ClockSource {
+        /** ktime_get - corrected monotonic clock, the default */
+        CLOCK_KTIME = 0,
+
+        /** sched_clock - raw local clock, needs normalization via the
+         *  calibration pair in the header */
+        CLOCK_SCHED = 1,
+    };
+
+    /** Per-event tag values */
+    enum EventTag {
+        /** Delta encoded IO event follows */
+        TAG_IO = 1,
+
+        /** Raw fixed-width event follows (varint size + payload) */
+        TAG_RAW = 2,
+    };
+
+    /**
+     * @brief Leading header of a v2 trace stream
+     *
+     * Streams with versionMinor 0 end after versionMinor; readers parse
+     * the clock fields only for minor >= 1.
+     */
+    struct FileHeader {
+        uint32_t magic;
+        uint16_t versionMajor;
+        uint16_t versionMinor;
+
+        /** Timestamp source of the event stream (ClockSource) */
+        uint8_t clockSource;
+
+        /** Reading of the event clock at capture start */
+        uint64_t clockRaw;
+
+        /** CLOCK_REALTIME ns taken at the same instant - together with
+         *  clockRaw this places raw event timestamps in real time */
+        uint64_t clockReal;
+    } __attribute__((packed));
+
+    /** Size of the header before the clock fields (minor 0 streams) */
+    static const size_t FILE_HEADER_V20_SIZE = 8;
+
+    /**
+     * @brief Appends varint encoded value to buffer
+     */
+    static void putVarint(std::vector<char> &buffer, uint64_t value);
+
+    /**
+     * @brief Reads varint encoded value
+     *
+     * @param[in,out] data Advanced past the consumed bytes
+     * @param end End of readable data
+     * @param[out] value Decoded value
+     *
+     * @retval true Value decoded
+     * @retval false Truncated input
+     */
+    static bool getVarint(const char *&data, const char *end, uint64_t &value);
+
+    /**
+     * @brief Maps signed value to unsigned varint space (zigzag)
+     */
+    static uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^
+               static_cast<uint64_t>(value >> 63);
+    }
+
+    /**
+     * @brief Reverse of zigzag()
+     */
+    static int64_t unzigzag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^
+               -static_cast<int64_t>(value & 1);
+    }
+
+    /**
+     * @brief Encodes one batch of fixed-width events
+     *
+     * @param data Batch of fixed-width events (as drained from a ring)
+     * @param size Batch size in bytes
+     * @param[out] output Encoded batch, prefixed with the event count
+     */
+    static void encodeBatch(const void *data,
+                            size_t size,
+                            std::vector<char> &output);
+
+    /**
+     * @brief Decodes one batch back into fixed-width events
+     *
+     * Used by the parsing path to transparently read v2 traces.
+     *
+     * @param data Encoded batch
+     * @param size Encoded batch size in bytes
+     * @param[out] output Fixed-width events
+     */
+    static void decodeBatch(const void *data,
+                            size_t size,
+                            std::vector<char> &output);
+};
+
+/**
+ * @brief Sink stage applying the v2 encoding to drained batches
+ *
+ * Writes the v2 file header on first batch, then one encoded batch per
+ * write into the wrapped sink. Combines with the LZ4 stage (v2 first,
+ * then compression) for the smallest output.
+ */
+class V2EncodingSink : public ITraceSink {
+public:
+    /**
+     * @param sink Sink receiving the encoded stream
+     */
+    V2EncodingSink(std::shared_ptr<ITraceSink> sink);
+    virtual ~V2EncodingSink() = default;
+
+    /**
+     * @brief Supplier of the clock fields for the file header
+     *
+     * Invoked when the header is written (first batch), which is after
+     * the kernel module attached and calibrated its clock - so the
+     * provider can read the live calibration from procfs.
+     */
+    typedef std::function<
+            void(uint8_t &source, uint64_t &raw, uint64_t &real)>
+            ClockInfoProvider;
+
+    /**
+     * @brief Sets the clock info provider
+     *
+     * Without a provider the header records CLOCK_KTIME with an empty
+     * calibration pair, matching the kernel default.
+     *
+     * @param provider Clock info supplier
+     */
+    void setClockInfoProvider(ClockInfoProvider provider);
+
+    void write(const void *data, size_t size) override;
+
+    void flush() override;
+
+private:
+    std::shared_ptr<ITraceSink> m_sink;
+    std::vector<char> m_encoded;
+    bool m_headerWritten;
+    ClockInfoProvider m_clockInfoProvider;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_TRACEFORMATV2_H
@@ -0,0 +1,119 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "TraceIndex.h"
+#include <octf/trace/iotrace_event.h>
+#include <octf/utils/Exception.h>
+#include <algorithm>
+
+namespace octf {
+
+const char TraceIndexWriter::SUFFIX[] = ".index";
+
+TraceIndexWriter::TraceIndexWriter(const std::string &path)
+        : m_file(path, std::ios::binary | std::ios::trunc)
+        , m_path(path) {
+    if (!m_file.is_open()) {
+        throw Exception("Cannot create trace index " + path);
+    }
+
+    uint32_t magic = INDEX_MAGIC;
+    m_file.write(reinterpret_cast<const char *>(&magic), sizeof(magic));
+}
+
+void TraceIndexWriter::append(const TraceIndexEntry &entry) {
+    m_file.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    if (!m_file.good()) {
+        throw Exception("Cannot write trace index " + m_path);
+    }
+}
+
+void TraceIndexWriter::flush() {
+    m_file.flush();
+}
+
+TraceIndex::TraceIndex(const std::string &path) : m_entries() {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return;
+    }
+
+    uint32_t magic = 0;
+    file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    if (file.gcount() != sizeof(magic) ||
+        magic != TraceIndexWriter::INDEX_MAGIC) {
+        return;
+    }
+
+    TraceIndexEntry entry;
+    while (file.read(reinterpret_cast<char *>(&entry), sizeof(entry))) {
+        m_entries.push_back(entry);
+    }
+}
+
+uint64_t TraceIndex::findOffset(uint64_t timestamp) const {
+    // Checkpoints are appended in capture order, so timestamps ascend
+    TraceIndexEntry key = {};
+    key.timestamp = timestamp;
+
+    auto it = std::upper_bound(
+            m_entries.begin(), m_entries.end(), key,
+            [](const TraceIndexEntry &a, const TraceIndexEntry &b) {
+                return a.timestamp < b.timestamp;
+            });
+
+    if (it == m_entries.begin()) {
+        return 0;
+    }
+
+    return std::prev(it)->offset;
+}
+
+IndexingTraceSink::IndexingTraceSink(std::shared_ptr<ITraceSink> sink,
+                                     const std::string &indexPath,
+                                     std::function<uint64_t()> offsetProvider,
+                                     uint64_t interval)
+        : m_sink(sink)
+        , m_writer(indexPath)
+        , m_offsetProvider(offsetProvider)
+        , m_interval(interval)
+        , m_lastOffset(0)
+        , m_anyCheckpoint(false) {
+    if (!m_sink) {
+        throw Exception("No sink provided for indexing stage");
+    }
+    if (!m_offsetProvider) {
+        throw Exception("No offset provider for indexing stage");
+    }
+}
+
+void IndexingTraceSink::write(const void *data, size_t size) {
+    if (size >= sizeof(struct iotrace_event_hdr)) {
+        uint64_t offset = m_offsetProvider();
+
+        if (!m_anyCheckpoint || offset - m_lastOffset >= m_interval) {
+            const struct iotrace_event_hdr *hdr =
+                    reinterpret_cast<const struct iotrace_event_hdr *>(data);
+
+            TraceIndexEntry entry;
+            entry.timestamp = hdr->timestamp;
+            entry.sid = hdr->sid;
+            entry.offset = offset;
+            m_writer.append(entry);
+
+            m_lastOffset = offset;
+            m_anyCheckpoint = true;
+        }
+    }
+
+    m_sink->write(data, size);
+}
+
+void IndexingTraceSink::flush() {
+    m_sink->flush();
+    m_writer.flush();
+}
+
+}  // namespace octf
@@ -0,0 +1,147 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_TRACEINDEX_H
+#define SOURCE_USERSPACE_TRACEINDEX_H
+
+#include <functional>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "TraceSink.h"
+
+namespace octf {
+
+/**
+ * @brief One checkpoint of a trace index sidecar
+ *
+ * Records that the shard file can be entered at @offset and that the
+ * first event found there carries @timestamp / @sid. Checkpoints are
+ * sparse; a range lookup seeks to the last checkpoint at or before the
+ * requested begin time and scans forward from there.
+ */
+struct TraceIndexEntry {
+    /** Timestamp of the first event at offset */
+    uint64_t timestamp;
+
+    /** Sequence id of the first event at offset */
+    uint64_t sid;
+
+    /** Byte offset of a batch boundary in the shard file */
+    uint64_t offset;
+} __attribute__((packed));
+
+/**
+ * @brief Writer of the index sidecar (<shard path> + ".index")
+ */
+class TraceIndexWriter {
+public:
+    /** Sidecar marker ("IOTX") */
+    static const uint32_t INDEX_MAGIC = 0x58544F49;
+
+    /** Sidecar suffix appended to the shard path */
+    static const char SUFFIX[];
+
+    /**
+     * @param path Sidecar path
+     */
+    TraceIndexWriter(const std::string &path);
+    virtual ~TraceIndexWriter() = default;
+
+    /**
+     * @brief Appends one checkpoint
+     */
+    void append(const TraceIndexEntry &entry);
+
+    /**
+     * @brief Flushes the sidecar to storage
+     */
+    void flush();
+
+private:
+    std::ofstream m_file;
+    std::string m_path;
+};
+
+/**
+ * @brief Loaded index sidecar of one shard
+ */
+class TraceIndex {
+public:
+    /**
+     * @param path Sidecar path; a missing or damaged sidecar yields an
+     *        empty index, so lookups degrade to scanning from offset 0
+     */
+    TraceIndex(const std::string &path);
+    virtual ~TraceIndex() = default;
+
+    /**
+     * @brief Finds the shard offset to enter for a begin timestamp
+     *
+     * @param timestamp Begin of the requested time range
+     *
+     * @return Offset of the last checkpoint at or before timestamp,
+     *         0 when none qualifies
+     */
+    uint64_t findOffset(uint64_t timestamp) const;
+
+    /**
+     * @brief Gets number of loaded checkpoints
+     */
+    size_t getEntryCount() const {
+        return m_entries.size();
+    }
+
+private:
+    std::vector<TraceIndexEntry> m_entries;
+};
+
+/**
+ * @brief Sink stage emitting index checkpoints while capturing
+ *
+ * Sits in front of the encoding stages, where batches still hold
+ * fixed-width events and the first event's timestamp is readable. A
+ * checkpoint is taken before the first batch and then whenever the
+ * wrapped stack has grown by the configured interval; the recorded
+ * offset is queried from the terminal sink, so it is a valid entry
+ * point into the file actually written.
+ */
+class IndexingTraceSink : public ITraceSink {
+public:
+    /** Default distance between checkpoints in output bytes */
+    static const uint64_t DEFAULT_INTERVAL = 16ULL * 1024ULL * 1024ULL;
+
+    /**
+     * @param sink Wrapped sink stack
+     * @param indexPath Sidecar path
+     * @param offsetProvider Returns current size of the terminal file
+     * @param interval Output bytes between checkpoints
+     */
+    IndexingTraceSink(std::shared_ptr<ITraceSink> sink,
+                      const std::string &indexPath,
+                      std::function<uint64_t()> offsetProvider,
+                      uint64_t interval = DEFAULT_INTERVAL);
+    virtual ~IndexingTraceSink() = default;
+
+    void write(const void *data, size_t size) override;
+
+    void flush() override;
+
+private:
+    std::shared_ptr<ITraceSink> m_sink;
+    TraceIndexWriter m_writer;
+    std::function<uint64_t()> m_offsetProvider;
+    uint64_t m_interval;
+
+    /** Terminal offset of the last checkpoint (none taken yet if 0
+     *  checkpoints emitted) */
+    uint64_t m_lastOffset;
+    bool m_anyCheckpoint;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_TRACEINDEX_H
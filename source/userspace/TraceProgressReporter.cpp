@@ -0,0 +1,176 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "TraceProgressReporter.h"
+#include <fcntl.h>
+#include <octf/utils/Exception.h>
+#include <octf/utils/Log.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+namespace octf {
+
+TraceProgressReporter::TraceProgressReporter(
+        const TraceDrainPipeline &pipeline,
+        DropProvider drops,
+        const Config &config)
+        : m_pipeline(pipeline)
+        , m_drops(drops)
+        , m_config(config)
+        , m_thread()
+        , m_running(false)
+        , m_listenFd(-1)
+        , m_agents()
+        , m_lastEvents(0)
+        , m_lastBytes(0) {}
+
+TraceProgressReporter::~TraceProgressReporter() {
+    stop();
+}
+
+void TraceProgressReporter::start() {
+    if (m_running ||
+        (!m_config.intervalSeconds && m_config.socketPath.empty())) {
+        return;
+    }
+
+    if (!m_config.socketPath.empty()) {
+        m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (m_listenFd < 0) {
+            throw Exception("Cannot create progress socket");
+        }
+
+        struct sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (m_config.socketPath.length() >= sizeof(address.sun_path)) {
+            close(m_listenFd);
+            m_listenFd = -1;
+            throw Exception("Progress socket path too long");
+        }
+        std::strcpy(address.sun_path, m_config.socketPath.c_str());
+
+        // A stale socket of a previous capture is not an error
+        unlink(m_config.socketPath.c_str());
+
+        if (bind(m_listenFd, reinterpret_cast<struct sockaddr *>(&address),
+                 sizeof(address)) ||
+            listen(m_listenFd, 4)) {
+            close(m_listenFd);
+            m_listenFd = -1;
+            throw Exception("Cannot bind progress socket " +
+                            m_config.socketPath);
+        }
+    }
+
+    m_running = true;
+    m_thread = std::thread(&TraceProgressReporter::reportLoop, this);
+}
+
+void TraceProgressReporter::stop() {
+    if (!m_running) {
+        return;
+    }
+
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    for (int agent : m_agents) {
+        close(agent);
+    }
+    m_agents.clear();
+
+    if (m_listenFd >= 0) {
+        close(m_listenFd);
+        m_listenFd = -1;
+        unlink(m_config.socketPath.c_str());
+    }
+}
+
+std::string TraceProgressReporter::formatLine(uint64_t events,
+                                              uint64_t bytes,
+                                              uint64_t drops) const {
+    uint32_t seconds =
+            m_config.intervalSeconds ? m_config.intervalSeconds : 1;
+    std::ostringstream line;
+
+    line << "events " << events << " (" << (events - m_lastEvents) / seconds
+         << "/s), MiB " << bytes / (1024 * 1024) << " ("
+         << (bytes - m_lastBytes) / seconds / (1024 * 1024)
+         << " MiB/s), drops " << drops;
+
+    return line.str();
+}
+
+void TraceProgressReporter::serveAgents(const std::string &line) {
+    if (m_listenFd < 0) {
+        return;
+    }
+
+    // Pick up agents which connected since the last tick
+    for (;;) {
+        int agent = accept(m_listenFd, nullptr, nullptr);
+        if (agent < 0) {
+            break;
+        }
+        m_agents.push_back(agent);
+    }
+
+    std::string payload = line + "\n";
+    for (size_t i = 0; i < m_agents.size();) {
+        ssize_t sent = send(m_agents[i], payload.data(), payload.size(),
+                            MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            // Agent went away
+            close(m_agents[i]);
+            m_agents.erase(m_agents.begin() + i);
+            continue;
+        }
+        i++;
+    }
+}
+
+void TraceProgressReporter::reportLoop() {
+    if (m_listenFd >= 0) {
+        // Nonblocking accepts - no agent must ever stall a sample
+        fcntl(m_listenFd, F_SETFL,
+              fcntl(m_listenFd, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+    uint32_t interval =
+            m_config.intervalSeconds ? m_config.intervalSeconds : 1;
+    auto next = std::chrono::steady_clock::now() +
+                std::chrono::seconds(interval);
+
+    while (m_running) {
+        // Sleep in small steps so stop() returns promptly
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() < next) {
+            continue;
+        }
+        next += std::chrono::seconds(interval);
+
+        uint64_t events = m_pipeline.getDrainedEvents();
+        uint64_t bytes = m_pipeline.getDrainedBytes();
+        uint64_t drops = m_drops ? m_drops() : 0;
+
+        std::string line = formatLine(events, bytes, drops);
+        if (m_config.intervalSeconds) {
+            log::cout << line << std::endl;
+        }
+        serveAgents(line);
+
+        m_lastEvents = events;
+        m_lastBytes = bytes;
+    }
+}
+
+}  // namespace octf
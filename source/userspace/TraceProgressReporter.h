@@ -0,0 +1,103 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_TRACEPROGRESSREPORTER_H
+#define SOURCE_USERSPACE_TRACEPROGRESSREPORTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TraceDrainPipeline.h"
+
+namespace octf {
+
+/**
+ * @brief Live progress surface of a running capture
+ *
+ * A reporter thread samples the pipeline's per-queue drain counters
+ * every interval and prints one rate/volume/drop line, so a running
+ * capture is observable instead of a black box until the summary. The
+ * drain hot path is untouched - the reporter only reads the padded
+ * counter slots; the drop counter read (a procfs access) happens on
+ * the reporter thread.
+ *
+ * Optionally the same lines are served over a local unix socket, so
+ * monitoring agents can follow a capture without scraping the tool's
+ * output.
+ */
+class TraceProgressReporter {
+public:
+    /**
+     * @brief Reads total events dropped by the kernel module so far
+     */
+    typedef std::function<uint64_t()> DropProvider;
+
+    struct Config {
+        /** Seconds between progress lines, 0 disables reporting */
+        uint32_t intervalSeconds = 0;
+
+        /** Unix socket path served to local agents, empty disables */
+        std::string socketPath;
+    };
+
+    /**
+     * @param pipeline Pipeline whose counters are sampled
+     * @param drops Drop counter source, may be empty
+     * @param config Reporting configuration
+     */
+    TraceProgressReporter(const TraceDrainPipeline &pipeline,
+                          DropProvider drops,
+                          const Config &config);
+    virtual ~TraceProgressReporter();
+
+    /**
+     * @brief Starts the reporter thread (no-op when disabled)
+     */
+    void start();
+
+    /**
+     * @brief Stops the reporter and closes the socket
+     */
+    void stop();
+
+private:
+    void reportLoop();
+
+    /**
+     * @brief Formats one progress line from the current totals
+     */
+    std::string formatLine(uint64_t events,
+                           uint64_t bytes,
+                           uint64_t drops) const;
+
+    /**
+     * @brief Accepts waiting agents and pushes line to all of them
+     */
+    void serveAgents(const std::string &line);
+
+    const TraceDrainPipeline &m_pipeline;
+    DropProvider m_drops;
+    Config m_config;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+
+    /** Listening socket, -1 when socket serving is off */
+    int m_listenFd;
+
+    /** Connected agent sockets */
+    std::vector<int> m_agents;
+
+    /** Totals of the previous sample for rate derivation */
+    uint64_t m_lastEvents;
+    uint64_t m_lastBytes;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_TRACEPROGRESSREPORTER_H
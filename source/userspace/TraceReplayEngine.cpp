@@ -0,0 +1,379 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "TraceReplayEngine.h"
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <octf/trace/iotrace_event.h>
+#include <octf/utils/Exception.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "ParallelTraceParser.h"
+
+namespace octf {
+
+namespace {
+
+/** Trace LBAs are 512B sectors */
+constexpr uint32_t SECTOR_SHIFT = 9;
+
+/** O_DIRECT alignment of the transfer buffers */
+constexpr size_t DIRECT_ALIGNMENT = 4096;
+
+/** Scheduled IOs buffered per worker; bounds replay-ahead memory and
+ *  backpressures the parser when the targets cannot keep up */
+constexpr size_t QUEUE_DEPTH = 4096;
+
+/** Upper bound of one replayed transfer (32 MiB); no real block
+ *  request is larger, so anything above marks a damaged event and must
+ *  not size a transfer buffer */
+constexpr uint32_t MAX_REPLAY_SECTORS =
+        (32ULL * 1024ULL * 1024ULL) >> SECTOR_SHIFT;
+
+/**
+ * @brief One IO scheduled for replay
+ */
+struct ReplayIo {
+    /** Scheduled issue time, ns from replay start */
+    uint64_t dueNs;
+
+    uint64_t lba;
+
+    /** Transfer size in sectors */
+    uint32_t len;
+
+    /** iotrace_event_operation_* value */
+    uint8_t operation;
+
+    /** Index into the target fd table */
+    int fdIndex;
+
+    /** End of replay marker */
+    bool stop;
+};
+
+/**
+ * @brief Replay worker owning one IO queue and one transfer buffer
+ *
+ * Sleeps until each IO's scheduled time, issues it synchronously with
+ * O_DIRECT and accounts the lag against the schedule.
+ */
+class ReplayWorker {
+public:
+    ReplayWorker(const std::vector<int> &fds,
+                 const ReplayConfig &config,
+                 std::chrono::steady_clock::time_point start)
+            : m_fds(fds)
+            , m_config(config)
+            , m_start(start)
+            , m_thread(&ReplayWorker::run, this) {}
+
+    ~ReplayWorker() {
+        if (m_buffer) {
+            free(m_buffer);
+        }
+    }
+
+    /**
+     * @brief Queues one IO, blocking while the queue is full
+     */
+    void push(const ReplayIo &io) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_notFull.wait(lock, [this] { return m_queue.size() < QUEUE_DEPTH; });
+        m_queue.push_back(io);
+        m_notEmpty.notify_one();
+    }
+
+    void stop() {
+        ReplayIo sentinel = {};
+        sentinel.stop = true;
+        push(sentinel);
+    }
+
+    void join() {
+        m_thread.join();
+    }
+
+    /** Worker share of the replay outcome, valid after join() */
+    ReplayStatistics stats;
+
+private:
+    void run() {
+        for (;;) {
+            ReplayIo io;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_notEmpty.wait(lock, [this] { return !m_queue.empty(); });
+                io = m_queue.front();
+                m_queue.pop_front();
+                m_notFull.notify_one();
+            }
+
+            if (io.stop) {
+                return;
+            }
+
+            std::this_thread::sleep_until(
+                    m_start + std::chrono::nanoseconds(io.dueNs));
+
+            uint64_t lagUs =
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() -
+                            (m_start + std::chrono::nanoseconds(io.dueNs)))
+                            .count();
+
+            try {
+                issue(io);
+            } catch (const std::exception &) {
+                // One unissuable IO (e.g. transfer buffer allocation
+                // failure) is counted, not fatal - an escape would
+                // terminate the process
+                stats.errors++;
+            }
+
+            stats.lagAvgUs += lagUs;
+            if (lagUs > stats.lagMaxUs) {
+                stats.lagMaxUs = lagUs;
+            }
+        }
+    }
+
+    void issue(const ReplayIo &io) {
+        size_t bytes = static_cast<size_t>(io.len) << SECTOR_SHIFT;
+        off_t offset = static_cast<off_t>(io.lba) << SECTOR_SHIFT;
+
+        stats.ios++;
+
+        if (m_config.dryRun) {
+            return;
+        }
+
+        int fd = m_fds[io.fdIndex];
+
+        if (io.operation == iotrace_event_operation_discard) {
+            uint64_t range[2] = {static_cast<uint64_t>(offset), bytes};
+            if (ioctl(fd, BLKDISCARD, range)) {
+                stats.errors++;
+            }
+            return;
+        }
+
+        grow(bytes);
+
+        bool write = m_config.allowWrites &&
+                     io.operation == iotrace_event_operation_wr;
+        ssize_t done = write ? pwrite(fd, m_buffer, bytes, offset)
+                             : pread(fd, m_buffer, bytes, offset);
+
+        if (done != static_cast<ssize_t>(bytes)) {
+            stats.errors++;
+        } else if (write) {
+            stats.writtenBytes += bytes;
+        } else {
+            stats.readBytes += bytes;
+        }
+    }
+
+    /**
+     * @brief Grows the aligned transfer buffer to at least size bytes
+     */
+    void grow(size_t size) {
+        if (m_bufferSize >= size) {
+            return;
+        }
+
+        void *buffer;
+        if (posix_memalign(&buffer, DIRECT_ALIGNMENT, size)) {
+            throw Exception("Cannot allocate replay transfer buffer");
+        }
+        // Deterministic payload for replayed writes
+        std::memset(buffer, 0, size);
+
+        free(m_buffer);
+        m_buffer = buffer;
+        m_bufferSize = size;
+    }
+
+    const std::vector<int> &m_fds;
+    const ReplayConfig &m_config;
+    std::chrono::steady_clock::time_point m_start;
+
+    std::deque<ReplayIo> m_queue;
+    std::mutex m_lock;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+
+    void *m_buffer = nullptr;
+    size_t m_bufferSize = 0;
+
+    std::thread m_thread;
+};
+
+}  // namespace
+
+TraceReplayEngine::TraceReplayEngine(const ReplayConfig &config)
+        : m_config(config) {
+    if (m_config.shardPaths.empty()) {
+        throw Exception("No trace shards to replay");
+    }
+    if (!m_config.dryRun && m_config.devicePaths.empty()) {
+        throw Exception("No replay target devices given");
+    }
+}
+
+ReplayStatistics TraceReplayEngine::replay() {
+    std::vector<int> fds;
+
+    if (!m_config.dryRun) {
+        int flags = (m_config.allowWrites ? O_RDWR : O_RDONLY) | O_DIRECT;
+
+        for (const auto &path : m_config.devicePaths) {
+            int fd = open(path.c_str(), flags);
+            if (fd < 0) {
+                for (int opened : fds) {
+                    close(opened);
+                }
+                throw Exception("Cannot open replay target " + path);
+            }
+            fds.push_back(fd);
+        }
+    }
+
+    uint32_t workerCount =
+            m_config.workers ? m_config.workers : m_config.shardPaths.size();
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::unique_ptr<ReplayWorker>> workers;
+    for (uint32_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(new ReplayWorker(fds, m_config, start));
+    }
+
+    ReplayStatistics total;
+    ParallelTraceParser parser(m_config.shardPaths);
+
+    // Traced devices are mapped onto targets in order of appearance
+    std::map<uint64_t, int> deviceIndex;
+    uint64_t baseTimestamp = 0;
+    uint64_t lastTimestamp = 0;
+    bool first = true;
+
+    try {
+        parser.parse([&](const struct iotrace_event_hdr *hdr) {
+            total.events++;
+
+            if (hdr->type != iotrace_event_type_io ||
+                hdr->size < sizeof(struct iotrace_event)) {
+                // Completions and descriptors are capture metadata,
+                // not workload
+                return;
+            }
+
+            const struct iotrace_event *event =
+                    reinterpret_cast<const struct iotrace_event *>(hdr);
+
+            if (first) {
+                baseTimestamp = hdr->timestamp;
+                first = false;
+            }
+            lastTimestamp = hdr->timestamp;
+
+            auto mapped = deviceIndex.find(event->dev_id);
+            if (mapped == deviceIndex.end()) {
+                mapped = deviceIndex
+                                 .insert({event->dev_id,
+                                          static_cast<int>(
+                                                  deviceIndex.size())})
+                                 .first;
+            }
+            if (!m_config.dryRun &&
+                mapped->second >= static_cast<int>(fds.size())) {
+                total.skipped++;
+                return;
+            }
+
+            if (event->operation == iotrace_event_operation_discard &&
+                !m_config.allowWrites) {
+                total.skipped++;
+                return;
+            }
+
+            if (!event->len || event->len > MAX_REPLAY_SECTORS) {
+                // Damaged or empty length - never let a corrupt shard
+                // dictate a transfer size
+                total.errors++;
+                return;
+            }
+
+            ReplayIo io = {};
+            io.dueNs = (hdr->timestamp - baseTimestamp) *
+                       m_config.timeScalePercent / 100;
+            io.lba = event->lba;
+            io.len = event->len;
+            io.operation = event->operation;
+            io.fdIndex = mapped->second;
+
+            // Hash by region so overlapping accesses keep their order
+            // while independent streams spread over the workers
+            uint64_t key = event->dev_id * 0x9E3779B97F4A7C15ULL ^
+                           (event->lba >> 3);
+            workers[key % workerCount]->push(io);
+        });
+    } catch (...) {
+        for (auto &worker : workers) {
+            worker->stop();
+        }
+        for (auto &worker : workers) {
+            worker->join();
+        }
+        for (int fd : fds) {
+            close(fd);
+        }
+        throw;
+    }
+
+    for (auto &worker : workers) {
+        worker->stop();
+    }
+    for (auto &worker : workers) {
+        worker->join();
+    }
+
+    total.achievedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    total.requestedUs = (lastTimestamp - baseTimestamp) *
+                        m_config.timeScalePercent / 100 / 1000;
+
+    for (const auto &worker : workers) {
+        total.ios += worker->stats.ios;
+        total.readBytes += worker->stats.readBytes;
+        total.writtenBytes += worker->stats.writtenBytes;
+        total.errors += worker->stats.errors;
+        total.lagAvgUs += worker->stats.lagAvgUs;
+        if (worker->stats.lagMaxUs > total.lagMaxUs) {
+            total.lagMaxUs = worker->stats.lagMaxUs;
+        }
+    }
+    if (total.ios) {
+        total.lagAvgUs /= total.ios;
+    }
+
+    for (int fd : fds) {
+        close(fd);
+    }
+
+    return total;
+}
+
+}  // namespace octf
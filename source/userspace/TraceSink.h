@@ -0,0 +1,42 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_TRACESINK_H
+#define SOURCE_USERSPACE_TRACESINK_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace octf {
+
+/**
+ * @brief Destination of drained trace data
+ *
+ * Sinks receive one write per drained batch and may be stacked - a
+ * transforming sink (e.g. compression) wraps the sink it forwards to.
+ * Sinks are driven from the drain path, so implementations report
+ * failures by throwing Exception rather than blocking indefinitely.
+ */
+class ITraceSink {
+public:
+    virtual ~ITraceSink() = default;
+
+    /**
+     * @brief Writes one drained batch to the sink
+     *
+     * @param data Batch payload
+     * @param size Payload size in bytes
+     */
+    virtual void write(const void *data, size_t size) = 0;
+
+    /**
+     * @brief Flushes data buffered by the sink (and the sinks it wraps)
+     */
+    virtual void flush() = 0;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_TRACESINK_H
@@ -0,0 +1,268 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "TraceStatistics.h"
+#include <octf/trace/iotrace_event.h>
+#include "iotrace_event_completion.h"
+
+namespace octf {
+
+/**
+ * @brief log2 bucket of a value, bucket 0 covers 0 and 1
+ */
+static unsigned log2Bucket(uint64_t value) {
+    unsigned bucket = 0;
+
+    while (value > 1) {
+        value >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void DeviceStatistics::merge(const DeviceStatistics &other) {
+    read.count += other.read.count;
+    read.sectors += other.read.sectors;
+    write.count += other.write.count;
+    write.sectors += other.write.sectors;
+    discard.count += other.discard.count;
+    discard.sectors += other.discard.sectors;
+
+    for (const auto &entry : other.ioClasses) {
+        ioClasses[entry.first] += entry.second;
+    }
+
+    for (unsigned i = 0; i < sizeof(sizeHistogram) / sizeof(*sizeHistogram);
+         i++) {
+        sizeHistogram[i] += other.sizeHistogram[i];
+    }
+    for (unsigned i = 0;
+         i < sizeof(latencyHistogram) / sizeof(*latencyHistogram); i++) {
+        latencyHistogram[i] += other.latencyHistogram[i];
+    }
+
+    unmatchedCompletions += other.unmatchedCompletions;
+    errors += other.errors;
+}
+
+TraceStatisticsCollector::TraceStatisticsCollector(uint32_t queueCount,
+                                                   uint32_t circBufferSizeMiB)
+        : TraceDrainPipeline(queueCount,
+                             circBufferSizeMiB,
+                             std::shared_ptr<ITraceSink>())
+        , m_queueStats(queueCount)
+        , m_queueLocks()
+        , m_aggregateKernel(getIoAggregateKernel()) {
+    for (uint32_t queue = 0; queue < queueCount; queue++) {
+        m_queueLocks.emplace_back(new std::mutex());
+    }
+}
+
+/**
+ * @brief Folds one run aggregate into the device aggregates
+ */
+static void applyAggregate(DeviceStatistics &device,
+                           const IoEventAggregate &aggregate) {
+    device.read.count += aggregate.count[IoEventAggregate::OP_READ];
+    device.read.sectors += aggregate.sectors[IoEventAggregate::OP_READ];
+    device.write.count += aggregate.count[IoEventAggregate::OP_WRITE];
+    device.write.sectors += aggregate.sectors[IoEventAggregate::OP_WRITE];
+    device.discard.count += aggregate.count[IoEventAggregate::OP_DISCARD];
+    device.discard.sectors += aggregate.sectors[IoEventAggregate::OP_DISCARD];
+
+    for (unsigned i = 0;
+         i < sizeof(device.sizeHistogram) / sizeof(*device.sizeHistogram);
+         i++) {
+        device.sizeHistogram[i] += aggregate.sizeHistogram[i];
+    }
+    for (unsigned ioClass = 0; ioClass < 256; ioClass++) {
+        if (aggregate.ioClasses[ioClass]) {
+            device.ioClasses[ioClass] += aggregate.ioClasses[ioClass];
+        }
+    }
+}
+
+void TraceStatisticsCollector::consumeBatch(uint32_t queue,
+                                            const void *data,
+                                            size_t size) {
+    const char *ptr = static_cast<const char *>(data);
+    const char *end = ptr + size;
+    QueueStatistics &stats = m_queueStats[queue];
+
+    std::lock_guard<std::mutex> guard(*m_queueLocks[queue]);
+
+    while (ptr + sizeof(struct iotrace_event_hdr) <= end) {
+        const struct iotrace_event_hdr *hdr =
+                reinterpret_cast<const struct iotrace_event_hdr *>(ptr);
+
+        if (hdr->size < sizeof(*hdr) || ptr + hdr->size > end) {
+            break;
+        }
+
+        if (hdr->type == iotrace_event_type_io &&
+            hdr->size == sizeof(struct iotrace_event)) {
+            const struct iotrace_event *event =
+                    reinterpret_cast<const struct iotrace_event *>(ptr);
+
+            // Take the maximal run of full IO events of this device -
+            // drained batches are dominated by exactly such runs and
+            // the aggregation kernel eats them 8 at a time
+            const char *runEnd = ptr + hdr->size;
+            size_t runLength = 1;
+            while (runEnd + sizeof(struct iotrace_event) <= end) {
+                const struct iotrace_event *next =
+                        reinterpret_cast<const struct iotrace_event *>(
+                                runEnd);
+                if (next->hdr.type != iotrace_event_type_io ||
+                    next->hdr.size != sizeof(struct iotrace_event) ||
+                    next->dev_id != event->dev_id) {
+                    break;
+                }
+                runEnd += next->hdr.size;
+                runLength++;
+            }
+
+            IoEventAggregate aggregate;
+            m_aggregateKernel(event, runLength, aggregate);
+            applyAggregate(stats.devices[event->dev_id], aggregate);
+
+            // Latency pairing stays per event - it is a table insert,
+            // not arithmetic
+            for (size_t i = 0; i < runLength; i++) {
+                uint64_t key =
+                        (static_cast<uint64_t>(event[i].dev_id) << 48) ^
+                        event[i].lba;
+                stats.inflight[key] = event[i].hdr.timestamp;
+            }
+
+            // Bound the pairing table - a stale entry means the
+            // completion arrived on another CPU
+            if (stats.inflight.size() > 64 * 1024) {
+                stats.inflight.clear();
+            }
+
+            ptr = runEnd;
+            continue;
+        }
+
+        if (hdr->type == IOTRACE_EVENT_TYPE_IO_COMPLETION &&
+            hdr->size == sizeof(struct iotrace_event_completion)) {
+            const struct iotrace_event_completion *event =
+                    reinterpret_cast<
+                            const struct iotrace_event_completion *>(ptr);
+            DeviceStatistics &device = stats.devices[event->dev_id];
+
+            if (event->error) {
+                device.errors++;
+            }
+
+            uint64_t key = (static_cast<uint64_t>(event->dev_id) << 48) ^
+                           event->lba;
+            auto submission = stats.inflight.find(key);
+            if (submission != stats.inflight.end() &&
+                hdr->timestamp >= submission->second) {
+                device.latencyHistogram[log2Bucket(
+                        hdr->timestamp - submission->second)]++;
+                stats.inflight.erase(submission);
+            } else {
+                device.unmatchedCompletions++;
+            }
+        }
+
+        ptr += hdr->size;
+    }
+}
+
+std::map<uint32_t, DeviceStatistics> TraceStatisticsCollector::getStatistics()
+        const {
+    std::map<uint32_t, DeviceStatistics> merged;
+
+    for (size_t queue = 0; queue < m_queueStats.size(); queue++) {
+        std::lock_guard<std::mutex> guard(*m_queueLocks[queue]);
+
+        for (const auto &entry : m_queueStats[queue].devices) {
+            merged[entry.first].merge(entry.second);
+        }
+    }
+
+    return merged;
+}
+
+void TraceStatisticsCollector::printSummary(std::ostream &out,
+                                            uint64_t intervalSeconds) const {
+    auto statistics = getStatistics();
+
+    for (const auto &entry : statistics) {
+        const DeviceStatistics &device = entry.second;
+        uint64_t requests = device.read.count + device.write.count +
+                            device.discard.count;
+        uint64_t sectors = device.read.sectors + device.write.sectors +
+                           device.discard.sectors;
+
+        out << "device " << entry.first << ":" << std::endl;
+        out << "  reads    " << device.read.count << " ("
+            << device.read.sectors / 2 << " KiB)" << std::endl;
+        out << "  writes   " << device.write.count << " ("
+            << device.write.sectors / 2 << " KiB)" << std::endl;
+        out << "  discards " << device.discard.count << " ("
+            << device.discard.sectors / 2 << " KiB)" << std::endl;
+
+        if (intervalSeconds) {
+            out << "  IOPS     " << requests / intervalSeconds << std::endl;
+            out << "  BW       " << sectors / 2 / intervalSeconds << " KiB/s"
+                << std::endl;
+        }
+
+        if (device.errors) {
+            out << "  errors   " << device.errors << std::endl;
+        }
+
+        out << "  io classes:";
+        for (const auto &ioClass : device.ioClasses) {
+            out << " " << static_cast<unsigned>(ioClass.first) << ":"
+                << ioClass.second;
+        }
+        out << std::endl;
+
+        out << "  size histogram (sectors):";
+        for (unsigned i = 0;
+             i < sizeof(device.sizeHistogram) /
+                         sizeof(*device.sizeHistogram);
+             i++) {
+            if (device.sizeHistogram[i]) {
+                out << " " << (1ULL << i) << ":" << device.sizeHistogram[i];
+            }
+        }
+        out << std::endl;
+
+        uint64_t latencySamples = 0;
+        for (unsigned i = 0;
+             i < sizeof(device.latencyHistogram) /
+                         sizeof(*device.latencyHistogram);
+             i++) {
+            latencySamples += device.latencyHistogram[i];
+        }
+        if (latencySamples) {
+            out << "  latency histogram (ns):";
+            for (unsigned i = 0;
+                 i < sizeof(device.latencyHistogram) /
+                             sizeof(*device.latencyHistogram);
+                 i++) {
+                if (device.latencyHistogram[i]) {
+                    out << " " << (1ULL << i) << ":"
+                        << device.latencyHistogram[i];
+                }
+            }
+            out << std::endl;
+        }
+        if (device.unmatchedCompletions) {
+            out << "  completions without local submission: "
+                << device.unmatchedCompletions << std::endl;
+        }
+    }
+}
+
+}  // namespace octf
@@ -0,0 +1,130 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SOURCE_USERSPACE_TRACESTATISTICS_H
+#define SOURCE_USERSPACE_TRACESTATISTICS_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#include "StatisticsSimd.h"
+#include "TraceDrainPipeline.h"
+
+namespace octf {
+
+/**
+ * @brief Streaming aggregates of one device
+ *
+ * All histograms are log2 scaled - bucket N covers [2^N, 2^(N+1)).
+ */
+struct DeviceStatistics {
+    /**
+     * @brief Per operation counters
+     */
+    struct OpStats {
+        /** Number of requests */
+        uint64_t count = 0;
+
+        /** Transferred sectors */
+        uint64_t sectors = 0;
+    };
+
+    OpStats read;
+    OpStats write;
+    OpStats discard;
+
+    /** Requests per DSS io class */
+    std::map<uint8_t, uint64_t> ioClasses;
+
+    /** log2(request sectors) histogram */
+    uint64_t sizeHistogram[32] = {};
+
+    /** log2(completion latency in ns) histogram */
+    uint64_t latencyHistogram[64] = {};
+
+    /** Completions without a submission seen on the same queue; their
+     *  latency is unknown (IO submitted and completed on different
+     *  CPUs), the throughput counters still cover them */
+    uint64_t unmatchedCompletions = 0;
+
+    /** Completions which reported an error */
+    uint64_t errors = 0;
+
+    /**
+     * @brief Accumulates other into this
+     */
+    void merge(const DeviceStatistics &other);
+};
+
+/**
+ * @brief Drain pipeline variant aggregating instead of storing
+ *
+ * Backs the stats-only capture mode: batches never reach a sink, each
+ * consumer thread updates its private per-device aggregates (no shared
+ * state on the hot path) and getStatistics() merges the per-thread
+ * structures on demand. Latency is derived by pairing completion
+ * events with submissions remembered on the same queue; cross CPU
+ * completions are counted as unmatched.
+ */
+class TraceStatisticsCollector : public TraceDrainPipeline {
+public:
+    /**
+     * @param queueCount Number of trace queues (rings) to drain
+     * @param circBufferSizeMiB Total size of kernel trace buffers in MiB
+     */
+    TraceStatisticsCollector(uint32_t queueCount, uint32_t circBufferSizeMiB);
+    virtual ~TraceStatisticsCollector() = default;
+
+    /**
+     * @brief Merges the per-thread aggregates
+     *
+     * Safe to call while draining; counters of batches in flight appear
+     * in the next merge.
+     *
+     * @return Statistics per device id
+     */
+    std::map<uint32_t, DeviceStatistics> getStatistics() const;
+
+    /**
+     * @brief Prints a human readable summary
+     *
+     * @param out Output stream
+     * @param intervalSeconds Capture length used for rate derivation,
+     *        0 skips the rates
+     */
+    void printSummary(std::ostream &out, uint64_t intervalSeconds) const;
+
+protected:
+    void consumeBatch(uint32_t queue, const void *data, size_t size) override;
+
+private:
+    /**
+     * @brief Aggregates of one consumer thread
+     */
+    struct QueueStatistics {
+        std::map<uint32_t, DeviceStatistics> devices;
+
+        /** Submission timestamps awaiting completion, keyed by
+         *  (dev_id, lba); bounded by periodic pruning */
+        std::unordered_map<uint64_t, uint64_t> inflight;
+    };
+
+    std::vector<QueueStatistics> m_queueStats;
+
+    /** Per-queue locks - only the owning thread and an occasional merge
+     *  take them, so they stay uncontended on the hot path */
+    std::vector<std::unique_ptr<std::mutex>> m_queueLocks;
+
+    /** Aggregation kernel for IO event runs, resolved once per machine
+     *  (AVX2 when available, scalar otherwise) */
+    IoAggregateFn m_aggregateKernel;
+};
+
+}  // namespace octf
+
+#endif  // SOURCE_USERSPACE_TRACESTATISTICS_H
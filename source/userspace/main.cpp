@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 #include "InterfaceKernelTraceCreatingImpl.h"
+#include "InterfaceTraceReplayingImpl.h"
 
 using namespace std;
 using namespace octf;
@@ -57,6 +58,11 @@ int main(int argc, char *argv[]) {
                     std::make_shared<InterfaceTraceParsingImpl>();
             ex.addLocalModule(interfaceTraceParsing);
 
+            // Trace Replaying Interface
+            InterfaceShRef interfaceTraceReplaying =
+                    std::make_shared<InterfaceTraceReplayingImpl>();
+            ex.addLocalModule(interfaceTraceReplaying);
+
             // Parse application input
             vector<string> arguments(argv, argv + argc);
             CLIList cliList;